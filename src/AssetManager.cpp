@@ -0,0 +1,262 @@
+#include "AssetManager.h"
+#include "DistanceField.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include <stb/stb_image.h>
+
+AssetManager assetManager;
+
+bool Asset::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]() { return finished(); });
+	return ready();
+}
+
+void Asset::finish(bool loaded) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		state = loaded ? ASSET_READY : ASSET_FAILED;
+	}
+	done.notify_all();
+}
+
+void ImageAsset::freePixels() {
+	if (pixels) {
+		stbi_image_free(pixels);
+		pixels = nullptr;
+	}
+}
+
+ImageAsset::~ImageAsset() {
+	freePixels();
+}
+
+//Renders one codepoint into a Glyph, false if the face doesn't have it
+static bool rasterizeCoverage(FT_Face face, uint32_t codepoint, Glyph& glyph) {
+	if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER) != 0)
+		return false;
+
+	FT_GlyphSlot slot = face->glyph;
+	glyph.width = slot->bitmap.width;
+	glyph.height = slot->bitmap.rows;
+	glyph.bearingX = slot->bitmap_left;
+	glyph.bearingY = slot->bitmap_top;
+	glyph.advance = (int)(slot->advance.x >> 6); //26.6 fixed point
+
+	//Pitch can be wider than the bitmap, copy row by row
+	glyph.pixels.resize((size_t)glyph.width * glyph.height);
+	for (int y = 0; y < glyph.height; y++)
+		for (int x = 0; x < glyph.width; x++)
+			glyph.pixels[(size_t)y * glyph.width + x] = slot->bitmap.buffer[y * slot->bitmap.pitch + x];
+
+	return true;
+}
+
+//Coverage, or a distance field made from coverage rendered OVERSAMPLE times bigger
+static bool rasterize(FontAsset& font, uint32_t codepoint, Glyph& glyph) {
+	if (!font.sdf)
+		return rasterizeCoverage(font.face, codepoint, glyph);
+
+	Glyph oversampled;
+	if (!rasterizeCoverage(font.face, codepoint, oversampled))
+		return false;
+
+	glyph = DistanceField::fromCoverage(oversampled, font.spread);
+	return true;
+}
+
+const Glyph* FontAsset::glyph(uint32_t codepoint) {
+	if (!ready())
+		return nullptr; //The worker still owns glyphs
+
+	auto cached = glyphs.find(codepoint);
+	if (cached != glyphs.end())
+		return &cached->second;
+
+	Glyph glyph;
+	if (!rasterize(*this, codepoint, glyph))
+		return nullptr;
+
+	return &(glyphs[codepoint] = std::move(glyph));
+}
+
+FontAsset::~FontAsset() {
+	if (face)
+		FT_Done_Face(face);
+	if (library)
+		FT_Done_FreeType(library);
+}
+
+static bool readWholeFile(const std::string& path, std::vector<unsigned char>& data) {
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in)
+		return false;
+
+	data.resize((size_t)in.tellg());
+	in.seekg(0);
+	return (bool)in.read((char*)data.data(), data.size());
+}
+
+//Existing handle for key, or a new one with created set
+template<typename T>
+static std::shared_ptr<T> findOrCreate(std::map<std::string, std::shared_ptr<Asset>>& assets, const std::string& key, const std::string& path, bool& created) {
+	auto existing = assets.find(key);
+	if (existing != assets.end()) {
+		created = false;
+		return std::static_pointer_cast<T>(existing->second);
+	}
+
+	std::shared_ptr<T> asset = std::make_shared<T>();
+	asset->path = path;
+	assets[key] = asset;
+	created = true;
+	return asset;
+}
+
+void AssetManager::init(ThreadPool* pool) {
+	this->pool = pool;
+	startTime = std::chrono::steady_clock::now();
+}
+
+bool AssetManager::mount(const std::string& path) {
+	return pack.open(path);
+}
+
+bool AssetManager::exists(const std::string& path) const {
+	const unsigned char* data;
+	size_t size;
+	return pack.find(path, data, size) || (bool)std::ifstream(path, std::ios::binary);
+}
+
+double AssetManager::elapsed() const {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+std::shared_ptr<FileAsset> AssetManager::loadFile(const std::string& path) {
+	bool created;
+	std::shared_ptr<FileAsset> asset = findOrCreate<FileAsset>(assets, "file:" + path, path, created);
+	if (!created)
+		return asset;
+
+	//Nothing to do for a file in the pack, the mapping is the data
+	if (pack.find(path, asset->data, asset->size)) {
+		asset->doneAt = elapsed();
+		asset->finish(true);
+		return asset;
+	}
+
+	pool->run([this, asset]() {
+		PROFILE_SCOPE("loadFile");
+		double start = elapsed();
+		bool loaded = readWholeFile(asset->path, asset->storage);
+		asset->data = asset->storage.data();
+		asset->size = asset->storage.size();
+		if (!loaded)
+			std::cout << "Error: Failed to read " << asset->path << std::endl;
+
+		asset->loadTime = elapsed() - start;
+		asset->doneAt = elapsed();
+		asset->finish(loaded);
+	});
+	return asset;
+}
+
+std::shared_ptr<ImageAsset> AssetManager::loadImage(const std::string& path) {
+	bool created;
+	std::shared_ptr<ImageAsset> asset = findOrCreate<ImageAsset>(assets, "image:" + path, path, created);
+	if (!created)
+		return asset;
+
+	const unsigned char* packed = nullptr;
+	size_t packedSize = 0;
+	pack.find(path, packed, packedSize);
+
+	pool->run([this, asset, packed, packedSize]() {
+		PROFILE_SCOPE("loadImage");
+		double start = elapsed();
+		int channels;
+
+		//Always ask for 4 channels, the upload is RGBA no matter what the file has
+		if (packed)
+			asset->pixels = stbi_load_from_memory(packed, (int)packedSize, &asset->width, &asset->height, &channels, 4);
+		else
+			asset->pixels = stbi_load(asset->path.c_str(), &asset->width, &asset->height, &channels, 4);
+		if (!asset->pixels)
+			std::cout << "Error: Failed to load image " << asset->path << ": " << stbi_failure_reason() << std::endl;
+
+		asset->loadTime = elapsed() - start;
+		asset->doneAt = elapsed();
+		asset->finish(asset->pixels != nullptr);
+	});
+	return asset;
+}
+
+std::shared_ptr<FontAsset> AssetManager::loadFont(const std::string& path, int pixelSize, bool sdf) {
+	bool created;
+	std::shared_ptr<FontAsset> asset = findOrCreate<FontAsset>(assets, (sdf ? "sdf:" : "font:") + path + "@" + std::to_string(pixelSize), path, created);
+	if (!created)
+		return asset;
+
+	asset->pixelSize = pixelSize;
+	asset->sdf = sdf;
+	asset->spread = sdf ? std::max(2, pixelSize / 8) : 0; //Enough for an outline or soft edge at big scales
+
+	const unsigned char* packed = nullptr;
+	size_t packedSize = 0;
+	pack.find(path, packed, packedSize);
+
+	pool->run([this, asset, packed, packedSize]() {
+		PROFILE_SCOPE("loadFont");
+		double start = elapsed();
+		bool loaded = false;
+
+		const unsigned char* data = packed;
+		size_t size = packedSize;
+		if (!data && readWholeFile(asset->path, asset->file)) {
+			data = asset->file.data();
+			size = asset->file.size();
+		}
+
+		if (!data)
+			std::cout << "Error: Failed to read font " << asset->path << std::endl;
+		else if (FT_Init_FreeType(&asset->library) != 0)
+			std::cout << "Error: Failed to init FreeType" << std::endl;
+		else if (FT_New_Memory_Face(asset->library, data, (FT_Long)size, 0, &asset->face) != 0)
+			std::cout << "Error: Failed to load font " << asset->path << std::endl;
+		else {
+			FT_Set_Pixel_Sizes(asset->face, 0, asset->sdf ? asset->pixelSize * DistanceField::OVERSAMPLE : asset->pixelSize);
+
+			//Printable ASCII covers scores and stats, anything else is done on demand by glyph()
+			for (uint32_t c = 32; c < 127; c++) {
+				Glyph glyph;
+				if (rasterize(*asset, c, glyph))
+					asset->glyphs[c] = std::move(glyph);
+			}
+			loaded = true;
+		}
+
+		asset->loadTime = elapsed() - start;
+		asset->doneAt = elapsed();
+		asset->finish(loaded);
+	});
+	return asset;
+}
+
+void AssetManager::report() {
+	for (auto& entry : assets) {
+		Asset& asset = *entry.second;
+		if (!asset.finished())
+			std::cout << "Asset " << entry.first << ": still loading" << std::endl;
+		else
+			std::cout << "Asset " << entry.first << ": " << (asset.ready() ? "" : "failed, ") << asset.loadTime * 1000 << " ms, done at " << asset.doneAt * 1000 << " ms" << std::endl;
+	}
+}
+
+void AssetManager::clear() {
+	assets.clear();
+	pack.close();
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//FreeType: https://freetype.org/freetype2/docs/tutorial/step1.html
+#include <freetype/config/ftheader.h>
+#include <freetype/freetype.h>
+#include FT_FREETYPE_H
+
+#include "ThreadPool.h"
+#include "AssetPack.h"
+
+enum AssetState {
+	ASSET_LOADING,
+	ASSET_READY,
+	ASSET_FAILED
+};
+
+//Something the AssetManager loads on the pool. Handles are shared_ptrs that exist straight away,
+//everything past state is written by the worker and is only safe to read once finished() is true
+struct Asset {
+	std::string path;
+	std::atomic<int> state{ ASSET_LOADING };
+	double loadTime = 0; //Seconds the worker spent on it
+	double doneAt = 0; //Seconds after AssetManager::init that it finished
+
+	std::mutex mutex;
+	std::condition_variable done;
+
+	virtual ~Asset() { }
+
+	bool ready() const { return state == ASSET_READY; }
+	bool failed() const { return state == ASSET_FAILED; }
+	bool finished() const { return state != ASSET_LOADING; }
+
+	//Blocks until the worker is done with it, true if it loaded
+	bool wait();
+
+	//Worker side, publishes the result and wakes anyone in wait()
+	void finish(bool loaded);
+};
+
+//Raw file contents, shader sources and cooked textures
+struct FileAsset : Asset {
+	const unsigned char* data = nullptr; //Into the mounted pack, or into storage for a loose file
+	size_t size = 0;
+	std::vector<unsigned char> storage;
+
+	std::string text() const { return std::string((const char*)data, size); }
+
+	//Whoever consumes the data calls this once it's done with it, the manager keeps the handle around
+	void release() {
+		std::vector<unsigned char>().swap(storage);
+		data = nullptr;
+		size = 0;
+	}
+};
+
+//Image decoded to RGBA
+struct ImageAsset : Asset {
+	int width = 0, height = 0;
+	unsigned char* pixels = nullptr;
+
+	//Whoever uploads the pixels calls this once they're copied out
+	void freePixels();
+
+	~ImageAsset();
+};
+
+struct Glyph {
+	int width = 0, height = 0;
+	int bearingX = 0, bearingY = 0; //Pixels from the pen position to the bitmap's left and top edges
+	int advance = 0; //Pixels to move the pen by afterwards
+	std::vector<unsigned char> pixels; //8 bit coverage, top row first
+};
+
+//Font at one pixel size, with printable ASCII already rasterized.
+//The face stays open so the render thread can rasterize anything else it needs once the asset is ready.
+//With sdf set the glyphs are distance fields (see DistanceField.h) rather than coverage, and can be drawn at any scale
+struct FontAsset : Asset {
+	int pixelSize = 0;
+	bool sdf = false;
+	int spread = 0; //Field pixels of distance either side of the edge, sdf only
+	std::vector<unsigned char> file; //Loose file contents, FreeType reads out of this (or the pack) for as long as face is open
+	FT_Library library = nullptr; //One per font, FreeType libraries can't be shared between threads
+	FT_Face face = nullptr;
+	std::map<uint32_t, Glyph> glyphs;
+
+	//Render thread only once ready(), rasterizes codepoint if it isn't cached yet. nullptr if the font can't
+	const Glyph* glyph(uint32_t codepoint);
+
+	~FontAsset();
+};
+
+//Loads everything from disk on the thread pool so startup isn't one read after another.
+//main() asks for what it needs before glfwInit, GLFW and glad come up while the workers read and decode,
+//and whoever uses an asset either polls ready() or wait()s at the last possible moment.
+//Asking for the same asset twice returns the same handle. Requests come from the main thread only.
+//With a pack mounted, anything in it is read straight out of the mapping and files only come off the disk as a fallback
+struct AssetManager {
+	ThreadPool* pool = nullptr;
+	AssetPack pack;
+	std::map<std::string, std::shared_ptr<Asset>> assets; //Keyed by kind and path
+	std::chrono::steady_clock::time_point startTime;
+
+	//Marks the start of the clock that time-to-first-frame is measured on, so call it first thing
+	void init(ThreadPool* pool);
+
+	//Maps a pack written by TextureCooker --pack, false if it can't. Everything loaded from it has to be done with before clear()
+	bool mount(const std::string& path);
+
+	//In the pack or on disk
+	bool exists(const std::string& path) const;
+
+	std::shared_ptr<FileAsset> loadFile(const std::string& path);
+	std::shared_ptr<ImageAsset> loadImage(const std::string& path);
+	std::shared_ptr<FontAsset> loadFont(const std::string& path, int pixelSize, bool sdf = false);
+
+	//Seconds since init()
+	double elapsed() const;
+
+	//Prints how long each asset took and when it was done
+	void report();
+
+	//Drops the manager's references and unmaps the pack. Handles held elsewhere stay valid, but not what they point into the pack
+	void clear();
+};
+
+extern AssetManager assetManager;
@@ -0,0 +1,209 @@
+#include "AssetPack.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t AssetPack::hash(const char* name, size_t length) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char)name[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash != 0 ? hash : 1; //0 marks an empty bucket
+}
+
+bool AssetPack::open(const std::string& path) {
+	close();
+
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+	file = fileHandle;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+
+	mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping)
+		base = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close();
+		return false;
+	}
+	size = (size_t)info.st_size;
+
+	void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (view != MAP_FAILED) {
+		base = (const unsigned char*)view;
+
+		//Ask for the whole pack now, one long read beats faulting it in a page at a time
+		madvise(view, size, MADV_WILLNEED);
+	}
+#endif
+
+	if (!base) {
+		std::cout << "Error: Failed to map " << path << std::endl;
+		close();
+		return false;
+	}
+
+	Header header;
+	if (size < sizeof(Header)) {
+		std::cout << "Error: " << path << " is truncated" << std::endl;
+		close();
+		return false;
+	}
+
+	memcpy(&header, base, sizeof(Header));
+	if (header.magic != MAGIC || header.version != VERSION || header.bucketCount == 0 || (header.bucketCount & (header.bucketCount - 1)) != 0 ||
+		size < sizeof(Header) + (size_t)header.bucketCount * sizeof(Bucket)) {
+		std::cout << "Error: " << path << " isn't a pack this version can read" << std::endl;
+		close();
+		return false;
+	}
+
+	buckets = (const Bucket*)(base + sizeof(Header));
+	bucketCount = header.bucketCount;
+
+	uint32_t used = 0;
+	for (uint32_t i = 0; i < bucketCount; i++) {
+		const Bucket& bucket = buckets[i];
+		if (bucket.hash == 0)
+			continue;
+
+		used++;
+		if ((size_t)bucket.nameOffset + bucket.nameLength > size || bucket.offset + bucket.size > size) {
+			std::cout << "Error: " << path << " is truncated" << std::endl;
+			close();
+			return false;
+		}
+	}
+
+	//find() stops probing at an empty bucket, a table without one would loop forever
+	if (used >= bucketCount) {
+		std::cout << "Error: " << path << " is corrupt, its table has no empty buckets" << std::endl;
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void AssetPack::close() {
+#ifdef _WIN32
+	if (base)
+		UnmapViewOfFile(base);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+	mapping = nullptr;
+	file = nullptr;
+#else
+	if (base)
+		munmap((void*)base, size);
+	if (file >= 0)
+		::close(file);
+	file = -1;
+#endif
+
+	base = nullptr;
+	size = 0;
+	buckets = nullptr;
+	bucketCount = 0;
+}
+
+bool AssetPack::find(const std::string& name, const unsigned char*& data, size_t& length) const {
+	if (!base)
+		return false;
+
+	uint64_t wanted = hash(name.data(), name.size());
+	for (uint32_t i = (uint32_t)wanted & (bucketCount - 1); ; i = (i + 1) & (bucketCount - 1)) {
+		const Bucket& bucket = buckets[i];
+		if (bucket.hash == 0)
+			return false; //open() made sure there's an empty bucket, so this always ends
+
+		if (bucket.hash == wanted && bucket.nameLength == name.size() && memcmp(base + bucket.nameOffset, name.data(), name.size()) == 0) {
+			data = base + bucket.offset;
+			length = (size_t)bucket.size;
+			return true;
+		}
+	}
+}
+
+bool AssetPack::write(const std::string& path, const std::vector<Entry>& entries) {
+	//Names are assumed unique, find() would only ever see the first of two
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+		return false;
+
+	uint32_t bucketCount = 1;
+	while (bucketCount < entries.size() * 2 + 1)
+		bucketCount *= 2;
+
+	std::vector<Bucket> table(bucketCount);
+	memset(table.data(), 0, table.size() * sizeof(Bucket));
+
+	//Names right after the table, then the payloads, aligned
+	uint64_t nameOffset = sizeof(Header) + (uint64_t)bucketCount * sizeof(Bucket);
+	uint64_t offset = nameOffset;
+	for (const Entry& entry : entries)
+		offset += entry.name.size();
+
+	std::vector<uint64_t> payloadOffsets;
+	for (const Entry& entry : entries) {
+		offset = (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+		payloadOffsets.push_back(offset);
+
+		uint64_t entryHash = hash(entry.name.data(), entry.name.size());
+		uint32_t i = (uint32_t)entryHash & (bucketCount - 1);
+		while (table[i].hash != 0)
+			i = (i + 1) & (bucketCount - 1);
+
+		table[i].hash = entryHash;
+		table[i].nameOffset = (uint32_t)nameOffset;
+		table[i].nameLength = (uint32_t)entry.name.size();
+		table[i].offset = offset;
+		table[i].size = entry.data.size();
+
+		nameOffset += entry.name.size();
+		offset += entry.data.size();
+	}
+
+	Header header = { MAGIC, VERSION, bucketCount, (uint32_t)entries.size() };
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)table.data(), table.size() * sizeof(Bucket));
+	for (const Entry& entry : entries)
+		out.write(entry.name.data(), entry.name.size());
+
+	const char padding[DATA_ALIGNMENT] = {};
+	for (size_t i = 0; i < entries.size(); i++) {
+		out.write(padding, payloadOffsets[i] - (uint64_t)out.tellp());
+		out.write((const char*)entries[i].data.data(), entries[i].data.size());
+	}
+
+	return (bool)out;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Every asset in one file, memory mapped so reading one is a pointer lookup instead of an open, a read and a copy.
+//Written by TextureCooker --pack. File layout, all little endian:
+//  Header
+//  Bucket[bucketCount], an open addressing hash table on the name (FNV-1a, linear probing, hash 0 = empty)
+//  Names, not terminated
+//  Payloads, each starting on a DATA_ALIGNMENT boundary so they can go straight to GL or a decoder
+struct AssetPack {
+	static const uint32_t MAGIC = 0x4B434150; //"PACK"
+	static const uint32_t VERSION = 1;
+	static const uint32_t DATA_ALIGNMENT = 64;
+
+	struct Header {
+		uint32_t magic, version;
+		uint32_t bucketCount; //Power of two, at least twice the entry count
+		uint32_t entryCount;
+	};
+
+	struct Bucket {
+		uint64_t hash;
+		uint32_t nameOffset, nameLength; //From the start of the file
+		uint64_t offset, size; //Payload, from the start of the file
+	};
+
+	struct Entry {
+		std::string name;
+		std::vector<unsigned char> data;
+	};
+
+	const unsigned char* base = nullptr; //Start of the mapping
+	size_t size = 0;
+	const Bucket* buckets = nullptr;
+	uint32_t bucketCount = 0;
+
+#ifdef _WIN32
+	void* file = nullptr; //HANDLEs, kept as void* so this header doesn't need windows.h
+	void* mapping = nullptr;
+#else
+	int file = -1;
+#endif
+
+	//Maps the file and checks its table, false if it's missing or broken
+	bool open(const std::string& path);
+
+	void close();
+
+	bool isOpen() const { return base != nullptr; }
+
+	//Points data at name's payload inside the mapping, which stays valid until close(). False if it isn't in the pack
+	bool find(const std::string& name, const unsigned char*& data, size_t& length) const;
+
+	static uint64_t hash(const char* name, size_t length);
+
+	static bool write(const std::string& path, const std::vector<Entry>& entries);
+};
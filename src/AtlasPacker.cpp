@@ -0,0 +1,95 @@
+#include "AtlasPacker.h"
+
+void AtlasPacker::init(int width, int height, int padding) {
+	this->width = width;
+	this->height = height;
+	this->padding = padding;
+
+	skyline.clear();
+	skyline.push_back({ 0, 0, width });
+}
+
+int AtlasPacker::fitAt(int index, int width) const {
+	int x = skyline[index].x;
+	if (x + width > this->width)
+		return -1;
+
+	//The rect has to sit on top of every segment it spans
+	int y = 0, remaining = width;
+	for (int i = index; remaining > 0; i++) {
+		if (skyline[i].y > y)
+			y = skyline[i].y;
+		remaining -= skyline[i].width;
+	}
+
+	return y;
+}
+
+bool AtlasPacker::pack(int width, int height, int& x, int& y) {
+	int paddedWidth = width + padding, paddedHeight = height + padding;
+
+	int best = -1, bestTop = 0, bestWidth = 0;
+	for (int i = 0; i < (int)skyline.size(); i++) {
+		int fit = fitAt(i, paddedWidth);
+		if (fit < 0 || fit + paddedHeight > this->height)
+			continue;
+
+		//Lowest top wins, ties go to the narrower segment so wide gaps stay open for wide rects
+		int top = fit + paddedHeight;
+		if (best < 0 || top < bestTop || (top == bestTop && skyline[i].width < bestWidth)) {
+			best = i;
+			bestTop = top;
+			bestWidth = skyline[i].width;
+		}
+	}
+
+	if (best < 0)
+		return false;
+
+	x = skyline[best].x;
+	y = bestTop - paddedHeight;
+
+	//New segment for the rect's top, then trim whatever it now covers
+	Segment top = { x, bestTop, paddedWidth };
+	skyline.insert(skyline.begin() + best, top);
+
+	for (int i = best + 1; i < (int)skyline.size(); i++) {
+		int covered = top.x + top.width - skyline[i].x;
+		if (covered <= 0)
+			break;
+
+		if (covered < skyline[i].width) {
+			skyline[i].x += covered;
+			skyline[i].width -= covered;
+			break;
+		}
+
+		skyline.erase(skyline.begin() + i);
+		i--;
+	}
+
+	//Merge neighbours at the same height
+	for (int i = 0; i + 1 < (int)skyline.size(); i++) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+			i--;
+		}
+	}
+
+	return true;
+}
+
+AtlasRegion& AtlasTable::add(const std::string& name, int x, int y, int width, int height) {
+	AtlasRegion& region = regions[name];
+	region.x = x;
+	region.y = y;
+	region.width = width;
+	region.height = height;
+
+	region.u0 = (float)x / this->width;
+	region.u1 = (float)(x + width) / this->width;
+	region.v0 = (float)(y + height) / this->height;
+	region.v1 = (float)y / this->height;
+	return region;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+//Skyline bottom-left rectangle packer. Keeps the top edge of everything packed so far as a list of horizontal
+//segments and puts each new rect wherever its top would end up lowest.
+struct AtlasPacker {
+	struct Segment {
+		int x, y, width;
+	};
+
+	int width = 0, height = 0;
+	int padding = 1; //Empty pixels kept around every rect so filtering doesn't bleed between them
+	std::vector<Segment> skyline;
+
+	void init(int width, int height, int padding = 1);
+
+	//Finds room for a width x height rect, returns false if it doesn't fit anywhere
+	bool pack(int width, int height, int& x, int& y);
+
+	//Lowest y a rect of this width can sit at if its left edge is at skyline[index], -1 if it runs off the edge
+	int fitAt(int index, int width) const;
+};
+
+//Where an image ended up in an atlas. UVs are flipped vertically (v0 is the image's bottom row) since image rows
+//are stored top first, so passing u0, v0, u1, v1 straight to a quad draws the image the right way up
+struct AtlasRegion {
+	float u0 = 0, v0 = 0, u1 = 0, v1 = 0;
+	int x = 0, y = 0, width = 0, height = 0; //Pixels, y down from the first row
+};
+
+//Name to region lookup for an atlas
+struct AtlasTable {
+	int width = 0, height = 0;
+	std::map<std::string, AtlasRegion> regions;
+
+	//Adds a region and works out its UVs
+	AtlasRegion& add(const std::string& name, int x, int y, int width, int height);
+};
@@ -0,0 +1,87 @@
+#include "CookedTexture.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+int CookedTexture::blockBytes(uint32_t format) {
+	switch (format) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return 8;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return 16;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM: return 16;
+	default: return 0;
+	}
+}
+
+std::string CookedTexture::cookedPath(const std::string& source) {
+	size_t dot = source.find_last_of('.');
+	size_t slash = source.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return source + ".ctex";
+
+	return source.substr(0, dot) + ".ctex";
+}
+
+bool CookedTexture::parse(const unsigned char* data, size_t size, const std::string& path) {
+	if (size < sizeof(Header))
+		return false;
+
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	if (header.magic != MAGIC || header.version != VERSION || blockBytes(header.format) == 0) {
+		std::cout << "Error: " << path << " isn't a cooked texture this version can read" << std::endl;
+		return false;
+	}
+
+	format = header.format;
+	width = header.width;
+	height = header.height;
+
+	size_t tableEnd = sizeof(Header) + header.levelCount * sizeof(Level);
+	if (size < tableEnd)
+		return false;
+
+	levels.resize(header.levelCount);
+	memcpy(levels.data(), data + sizeof(Header), header.levelCount * sizeof(Level));
+
+	for (const Level& level : levels) {
+		if ((size_t)level.offset + level.size > size) {
+			std::cout << "Error: " << path << " is truncated" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool CookedTexture::write(const std::string& path, uint32_t format, uint32_t width, uint32_t height, const std::vector<std::vector<unsigned char>>& levelData) {
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+		return false;
+
+	Header header = { MAGIC, VERSION, format, width, height, (uint32_t)levelData.size() };
+
+	//Lay the levels out after the table, aligned
+	std::vector<Level> table(levelData.size());
+	uint32_t offset = (uint32_t)(sizeof(Header) + table.size() * sizeof(Level));
+	for (size_t i = 0; i < levelData.size(); i++) {
+		offset = (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+
+		table[i].offset = offset;
+		table[i].size = (uint32_t)levelData[i].size();
+		table[i].width = width >> i > 0 ? width >> i : 1;
+		table[i].height = height >> i > 0 ? height >> i : 1;
+		offset += table[i].size;
+	}
+
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)table.data(), table.size() * sizeof(Level));
+
+	const char padding[DATA_ALIGNMENT] = {};
+	for (size_t i = 0; i < levelData.size(); i++) {
+		out.write(padding, table[i].offset - out.tellp());
+		out.write((const char*)levelData[i].data(), levelData[i].size());
+	}
+
+	return (bool)out;
+}
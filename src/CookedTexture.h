@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+//S3TC isn't core GL, so glad (core only) doesn't define these
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+//Block compressed texture with its whole mip chain, as written by tools/TextureCooker.
+//File layout, all little endian:
+//  Header
+//  Level[levelCount], offsets are from the start of the file
+//  Level data, each level starts on a DATA_ALIGNMENT boundary so it can go straight to glCompressedTexSubImage2D
+struct CookedTexture {
+	static const uint32_t MAGIC = 0x58455443; //"CTEX"
+	static const uint32_t VERSION = 1;
+	static const uint32_t DATA_ALIGNMENT = 16;
+
+	struct Header {
+		uint32_t magic, version;
+		uint32_t format; //GL internal format, GL_COMPRESSED_RGB_S3TC_DXT1_EXT etc.
+		uint32_t width, height, levelCount;
+	};
+
+	struct Level {
+		uint32_t offset, size;
+		uint32_t width, height;
+	};
+
+	uint32_t format = 0, width = 0, height = 0;
+	std::vector<Level> levels; //Offsets index into the bytes given to parse(), which the caller keeps
+
+	//Bytes per 4x4 block for format, 0 if it isn't one we know
+	static int blockBytes(uint32_t format);
+
+	//Where the cooked version of a source image lives, "resources/acererak.png" -> "resources/acererak.ctex"
+	static std::string cookedPath(const std::string& source);
+
+	//Reads the header and level table of a cooked file already in memory, from AssetManager or an AssetPack.
+	//path is only for errors
+	bool parse(const unsigned char* data, size_t size, const std::string& path);
+
+	//levelData[i] is the compressed data for mip i, level 0 is width x height
+	static bool write(const std::string& path, uint32_t format, uint32_t width, uint32_t height, const std::vector<std::vector<unsigned char>>& levelData);
+};
@@ -0,0 +1,124 @@
+#include "DistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const float FAR_AWAY = 1e20f;
+
+//Felzenszwalb & Huttenlocher's exact 1D squared distance transform, "Distance Transforms of Sampled Functions".
+//f is 0 at feature pixels and FAR_AWAY elsewhere, d gets the squared distance to the nearest one. v and z are scratch
+static void transform1D(const float* f, float* d, int* v, float* z, int n) {
+	int k = 0;
+	v[0] = 0;
+	z[0] = -FAR_AWAY;
+	z[1] = FAR_AWAY;
+
+	for (int q = 1; q < n; q++) {
+		float s = ((f[q] + (float)q * q) - (f[v[k]] + (float)v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+		while (s <= z[k]) {
+			k--;
+			s = ((f[q] + (float)q * q) - (f[v[k]] + (float)v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+		}
+
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = FAR_AWAY;
+	}
+
+	k = 0;
+	for (int q = 0; q < n; q++) {
+		while (z[k + 1] < q)
+			k++;
+		d[q] = (float)(q - v[k]) * (q - v[k]) + f[v[k]];
+	}
+}
+
+//Squared distance from every pixel to the nearest one where feature is true, columns then rows
+static void transform2D(const std::vector<unsigned char>& feature, int width, int height, std::vector<float>& distance) {
+	int n = std::max(width, height);
+	std::vector<float> f(n), d(n), z(n + 1);
+	std::vector<int> v(n);
+
+	distance.resize((size_t)width * height);
+	for (size_t i = 0; i < distance.size(); i++)
+		distance[i] = feature[i] ? 0.0f : FAR_AWAY;
+
+	for (int x = 0; x < width; x++) {
+		for (int y = 0; y < height; y++)
+			f[y] = distance[(size_t)y * width + x];
+		transform1D(f.data(), d.data(), v.data(), z.data(), height);
+		for (int y = 0; y < height; y++)
+			distance[(size_t)y * width + x] = d[y];
+	}
+
+	for (int y = 0; y < height; y++) {
+		float* row = distance.data() + (size_t)y * width;
+		std::copy(row, row + width, f.begin());
+		transform1D(f.data(), row, v.data(), z.data(), width);
+	}
+}
+
+static int floorDiv(int a, int b) {
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static int ceilDiv(int a, int b) {
+	return -floorDiv(-a, b);
+}
+
+Glyph DistanceField::fromCoverage(const Glyph& oversampled, int spread) {
+	const int os = OVERSAMPLE;
+
+	Glyph glyph;
+	glyph.advance = (oversampled.advance + os / 2) / os;
+	if (oversampled.width == 0 || oversampled.height == 0)
+		return glyph; //Blank, like space
+
+	//Field pixel edges have to land on oversampled pixel edges, so round the box out to whole field pixels
+	int left = floorDiv(oversampled.bearingX, os) - spread;
+	int right = ceilDiv(oversampled.bearingX + oversampled.width, os) + spread;
+	int top = ceilDiv(oversampled.bearingY, os) + spread;
+	int bottom = floorDiv(oversampled.bearingY - oversampled.height, os) - spread;
+
+	glyph.bearingX = left;
+	glyph.bearingY = top;
+	glyph.width = right - left;
+	glyph.height = top - bottom;
+
+	//Oversampled coverage on a canvas the size of the field, thresholded into inside and outside
+	int canvasWidth = glyph.width * os, canvasHeight = glyph.height * os;
+	int offsetX = oversampled.bearingX - left * os, offsetY = top * os - oversampled.bearingY;
+
+	std::vector<unsigned char> inside((size_t)canvasWidth * canvasHeight, 0), outside((size_t)canvasWidth * canvasHeight, 1);
+	for (int y = 0; y < oversampled.height; y++) {
+		for (int x = 0; x < oversampled.width; x++) {
+			if (oversampled.pixels[(size_t)y * oversampled.width + x] >= 128) {
+				size_t i = (size_t)(y + offsetY) * canvasWidth + x + offsetX;
+				inside[i] = 1;
+				outside[i] = 0;
+			}
+		}
+	}
+
+	std::vector<float> toInside, toOutside;
+	transform2D(inside, canvasWidth, canvasHeight, toInside);
+	transform2D(outside, canvasWidth, canvasHeight, toOutside);
+
+	//Sample the middle of each field pixel, positive inside
+	glyph.pixels.resize((size_t)glyph.width * glyph.height);
+	for (int y = 0; y < glyph.height; y++) {
+		for (int x = 0; x < glyph.width; x++) {
+			size_t i = (size_t)(y * os + os / 2) * canvasWidth + x * os + os / 2;
+			//Distances are between pixel centers, the edge itself is half a pixel further in
+			float distance = toInside[i] == 0.0f ? std::sqrt(toOutside[i]) - 0.5f : 0.5f - std::sqrt(toInside[i]);
+			distance /= os;
+
+			float value = 128.0f + distance / spread * 127.0f;
+			glyph.pixels[(size_t)y * glyph.width + x] = (unsigned char)std::min(255.0f, std::max(0.0f, value + 0.5f));
+		}
+	}
+
+	return glyph;
+}
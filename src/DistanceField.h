@@ -0,0 +1,17 @@
+#pragma once
+
+#include "AssetManager.h"
+
+//Signed distance field glyphs. One field drawn through fragment.frag's SDF path stays sharp at any size, so a single
+//small atlas covers both the huge scores and the tiny overlays instead of one bitmap atlas per pixel size.
+//The field is single channel: corners come out slightly rounded when scaled up a lot, which a multi-channel field
+//would avoid, but that needs edge coloring on the outlines and Arial's corners hold up fine at our sizes.
+namespace DistanceField {
+	//Glyphs are rendered this many times bigger than the field, so the distances are measured to sub-pixel accuracy
+	const int OVERSAMPLE = 4;
+
+	//Field for a glyph FreeType rendered at OVERSAMPLE times the font's size. spread is how far from the edge, in field
+	//pixels, distances are kept before they clamp, the output is padded by it on every side.
+	//In the result 128 is the edge, more is inside, and metrics are at field size
+	Glyph fromCoverage(const Glyph& oversampled, int spread);
+}
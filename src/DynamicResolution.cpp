@@ -0,0 +1,48 @@
+#include "DynamicResolution.h"
+#include "GLRenderBackend.h"
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution dynamicResolution;
+
+static const float SMOOTHING = 0.25f; //Of each new GPU time folded into smoothed
+static const float DROP_RATE = 0.25f, GROW_RATE = 0.05f; //How much of the way to the ideal scale we move per frame
+static const float GROW_HEADROOM = 0.85f; //Only grow while under this much of budget, so we don't sit right on the edge
+
+void DynamicResolution::init(int width, int height, float budget, float minScale) {
+	fullWidth = width;
+	fullHeight = height;
+	this->budget = budget;
+	this->minScale = minScale;
+	scale = 1.0f;
+	enabled = true;
+}
+
+static int roundSize(float size, int full) {
+	int rounded = ((int)(size + DynamicResolution::SIZE_STEP / 2) / DynamicResolution::SIZE_STEP) * DynamicResolution::SIZE_STEP;
+	return std::min(full, std::max((int)DynamicResolution::SIZE_STEP, rounded));
+}
+
+void DynamicResolution::update(GLRenderBackend& backend) {
+	if (!enabled)
+		return;
+
+	if (gpuProfiler.totalFrames != seenFrames) {
+		seenFrames = gpuProfiler.totalFrames;
+		smoothed = smoothed == 0 ? gpuProfiler.lastFrame : smoothed + (gpuProfiler.lastFrame - smoothed) * SMOOTHING;
+
+		//Fill cost goes with pixel count, so the scale that would just fit the budget is sqrt(budget / cost) of this one
+		float ideal = scale * std::sqrt(budget / std::max(smoothed, 0.01f));
+		if (ideal < scale)
+			scale += (ideal - scale) * DROP_RATE;
+		else if (smoothed < budget * GROW_HEADROOM)
+			scale += (ideal - scale) * GROW_RATE;
+
+		scale = std::min(1.0f, std::max(minScale, scale));
+	}
+
+	backend.sceneWidth = roundSize(fullWidth * scale, fullWidth);
+	backend.sceneHeight = roundSize(fullHeight * scale, fullHeight);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+struct GLRenderBackend;
+
+//Draws the playfield at a lower resolution when the GPU can't keep up, and upscales it to the window, so a slow
+//machine loses sharpness instead of frames. The HUD is still drawn at full resolution on top.
+//The backend's scene framebuffer is allocated once at full size and only the viewport into it shrinks, so changing
+//scale never reallocates anything. The controller runs on gpuProfiler's per-frame times, which are a few frames old, so it drops
+//quickly when over budget and creeps back up slowly to avoid chasing its own lag.
+struct DynamicResolution {
+	static const int SIZE_STEP = 8; //Scene sizes are rounded to this, so tiny changes don't make the image shimmer
+
+	bool enabled = false;
+	int fullWidth = 0, fullHeight = 0;
+	float scale = 1.0f, minScale = 0.5f;
+	float budget = 0; //Ms of GPU time per frame to aim for
+	float smoothed = 0; //Ms, recent GPU frame times averaged
+	int seenFrames = 0; //gpuProfiler.totalFrames last time we looked
+
+	//Needs gpuProfiler running and a full size backend.scene. budget is in ms, width and height are the scene's full size
+	void init(int width, int height, float budget, float minScale);
+
+	//Once a frame before rendering, picks the scene size from the latest GPU time and hands it to backend
+	void update(GLRenderBackend& backend);
+};
+
+extern DynamicResolution dynamicResolution;
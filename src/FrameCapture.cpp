@@ -0,0 +1,222 @@
+#include "FrameCapture.h"
+#include "GLState.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+bool FrameCapture::start(const std::string& path, int width, int height, int frameRate, bool gl) {
+	this->width = width;
+	this->height = height;
+
+	file.open(path, std::ios::binary);
+	if (!file) {
+		std::cout << "Error: Couldn't open capture file " << path << std::endl;
+		return false;
+	}
+
+	//4:2:0 with chroma centered between each 2x2 block, which is all C420jpeg says. Levels are full range BT.601, and
+	//readers like ffmpeg and mpv assume limited range unless XCOLORRANGE=FULL tells them otherwise
+	file << "YUV4MPEG2 W" << width << " H" << height << " F" << frameRate << ":1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+
+	GLsizeiptr size = (GLsizeiptr)width * height * 4;
+	for (int i = 0; i < SLOTS; i++) {
+		if (gl) {
+			const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			glGenBuffers(1, &slots[i].pbo);
+			glState.bindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].pbo);
+			glBufferStorage(GL_PIXEL_PACK_BUFFER, size, NULL, flags);
+			slots[i].pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags);
+		}
+		else {
+			slots[i].cpuPixels.resize(size);
+			slots[i].pixels = slots[i].cpuPixels.data();
+			slots[i].bottomUp = false;
+		}
+	}
+	if (gl)
+		glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	stopping = false;
+	encoder = std::thread(&FrameCapture::encodeLoop, this);
+	return true;
+}
+
+void FrameCapture::collect(bool wait) {
+	while (!reading.empty()) {
+		Slot& slot = slots[reading.front()];
+
+		GLenum result = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+			return; //Not done yet, and later slots were issued after this one so they won't be either
+
+		glDeleteSync(slot.fence);
+		slot.fence = 0;
+
+		slot.state = SLOT_ENCODING;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			encodeQueue.push_back(reading.front());
+		}
+		queueReady.notify_one();
+		reading.pop_front();
+	}
+}
+
+void FrameCapture::captureGL(GLuint framebuffer) {
+	auto begin = std::chrono::steady_clock::now();
+
+	collect(false);
+
+	Slot& slot = slots[next];
+	if (slot.state != SLOT_FREE)
+		dropped++; //Encoder or GPU is too far behind, skip this frame rather than wait
+	else {
+		glState.bindFramebuffer(framebuffer);
+		if (framebuffer == 0)
+			glReadBuffer(GL_BACK);
+		glState.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+		//With a pack buffer bound this only queues the copy, the last argument is an offset into the buffer
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot.state = SLOT_READING;
+		reading.push_back(next);
+		next = (next + 1) % SLOTS;
+		captured++;
+	}
+
+	captureTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void FrameCapture::captureSoftware(const unsigned char* pixels) {
+	auto begin = std::chrono::steady_clock::now();
+
+	Slot& slot = slots[next];
+	if (slot.state != SLOT_FREE)
+		dropped++;
+	else {
+		memcpy(slot.cpuPixels.data(), pixels, slot.cpuPixels.size());
+
+		slot.state = SLOT_ENCODING;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			encodeQueue.push_back(next);
+		}
+		queueReady.notify_one();
+		next = (next + 1) % SLOTS;
+		captured++;
+	}
+
+	captureTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void FrameCapture::encodeLoop() {
+	while (true) {
+		int index;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueReady.wait(lock, [this]() { return stopping || !encodeQueue.empty(); });
+			if (encodeQueue.empty())
+				return;
+
+			index = encodeQueue.front();
+			encodeQueue.pop_front();
+		}
+
+		encode(slots[index]);
+		slots[index].state = SLOT_FREE;
+	}
+}
+
+static unsigned char clampByte(int value) {
+	return (unsigned char)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+void FrameCapture::encode(const Slot& slot) {
+	int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	yuv.resize(width * height + chromaWidth * chromaHeight * 2);
+	unsigned char* yPlane = yuv.data();
+	unsigned char* uPlane = yPlane + width * height;
+	unsigned char* vPlane = uPlane + chromaWidth * chromaHeight;
+
+	//Fixed point BT.601 full range, coefficients scaled by 256
+	for (int y = 0; y < height; y++) {
+		const unsigned char* row = slot.pixels + (size_t)(slot.bottomUp ? height - 1 - y : y) * width * 4;
+		unsigned char* out = yPlane + y * width;
+
+		for (int x = 0; x < width; x++) {
+			int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+			out[x] = (unsigned char)((77 * r + 150 * g + 29 * b + 128) >> 8);
+		}
+	}
+
+	//Chroma from the average of each 2x2 block
+	for (int cy = 0; cy < chromaHeight; cy++) {
+		int y0 = cy * 2, y1 = y0 + 1 < height ? y0 + 1 : y0;
+		const unsigned char* row0 = slot.pixels + (size_t)(slot.bottomUp ? height - 1 - y0 : y0) * width * 4;
+		const unsigned char* row1 = slot.pixels + (size_t)(slot.bottomUp ? height - 1 - y1 : y1) * width * 4;
+
+		for (int cx = 0; cx < chromaWidth; cx++) {
+			int x0 = cx * 2 * 4, x1 = (cx * 2 + 1 < width ? cx * 2 + 1 : cx * 2) * 4;
+			int r = row0[x0] + row0[x1] + row1[x0] + row1[x1];
+			int g = row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1];
+			int b = row0[x0 + 2] + row0[x1 + 2] + row1[x0 + 2] + row1[x1 + 2];
+
+			//Sums are 4x the average, so shift by 10 instead of 8. >> rounds down for negatives too, so no bias around 128
+			uPlane[cy * chromaWidth + cx] = clampByte(((-43 * r - 85 * g + 128 * b) >> 10) + 128);
+			vPlane[cy * chromaWidth + cx] = clampByte(((128 * r - 107 * g - 21 * b) >> 10) + 128);
+		}
+	}
+
+	file << "FRAME\n";
+	file.write((const char*)yuv.data(), yuv.size());
+}
+
+void FrameCapture::stop() {
+	if (!file.is_open())
+		return;
+
+	//Flush GL reads still in flight. A few seconds is plenty for a handful of copies, if the GPU still hasn't
+	//finished them it's hung or gone, and the frames are given up on rather than read from buffers we're about to free
+	for (int attempt = 0; attempt < 5 && !reading.empty(); attempt++)
+		collect(true);
+
+	if (!reading.empty()) {
+		std::cout << "Error: Gave up waiting on " << reading.size() << " frame reads, they're missing from the capture" << std::endl;
+		for (int index : reading) {
+			glDeleteSync(slots[index].fence);
+			slots[index].fence = 0;
+			slots[index].state = SLOT_FREE;
+		}
+		captured -= (int)reading.size();
+		dropped += (int)reading.size();
+		reading.clear();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueReady.notify_one();
+	encoder.join();
+
+	file.close();
+
+	for (int i = 0; i < SLOTS; i++) {
+		if (slots[i].pbo) {
+			glState.bindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].pbo);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			glState.deleteBuffer(slots[i].pbo);
+			slots[i].pbo = 0;
+		}
+	}
+
+	std::cout << "Captured " << captured << " frames, dropped " << dropped << ", "
+		<< (captured + dropped > 0 ? captureTime * 1000.0 / (captured + dropped) : 0) << " ms per frame on the render thread" << std::endl;
+}
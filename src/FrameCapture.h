@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+//Records every frame to a Y4M video without stalling the render thread.
+//GL frames are read back into a ring of persistently mapped pixel pack buffers, each fenced, and handed to an encoder
+//thread once the fence says the copy finished. The encoder reads straight out of the mapping, so the render thread
+//never waits on glReadPixels or copies pixels itself. If every slot is busy the frame is dropped and counted.
+struct FrameCapture {
+	static const int SLOTS = 4;
+
+	enum SlotState {
+		SLOT_FREE,
+		SLOT_READING, //glReadPixels issued, waiting on the fence
+		SLOT_ENCODING //Owned by the encoder thread
+	};
+
+	struct Slot {
+		std::atomic<int> state{ SLOT_FREE };
+		GLuint pbo = 0;
+		const unsigned char* pixels = nullptr; //RGBA, either the PBO mapping or cpuPixels
+		std::vector<unsigned char> cpuPixels; //Used for frames from the software renderer
+		GLsync fence = 0;
+		bool bottomUp = true; //GL rows start at the bottom
+	};
+
+	int width = 0, height = 0;
+	Slot slots[SLOTS];
+	int next = 0; //Next slot to capture into
+	std::deque<int> reading; //Slots in SLOT_READING, oldest first
+
+	std::ofstream file;
+	std::thread encoder;
+	std::mutex queueMutex;
+	std::condition_variable queueReady;
+	std::deque<int> encodeQueue;
+	bool stopping = false;
+	std::vector<unsigned char> yuv; //Encoder thread scratch, one Y4M frame
+
+	int captured = 0, dropped = 0;
+	double captureTime = 0; //Total render thread time spent in capture calls, in seconds
+
+	//Opens path and starts the encoder thread, gl is false if frames will only come from captureSoftware().
+	//frameRate is what the video plays back at, it should match how often frames are captured
+	bool start(const std::string& path, int width, int height, int frameRate, bool gl);
+
+	//Queues a read of the framebuffer currently bound for reading, and passes finished reads on to the encoder
+	void captureGL(GLuint framebuffer);
+
+	//Copies a software rendered RGBA frame, row 0 at the top
+	void captureSoftware(const unsigned char* pixels);
+
+	//Waits for every pending frame to be written, then closes the file and prints how it went
+	void stop();
+
+	//Moves finished reads to the encoder, render thread only. With wait it waits up to a second for each one,
+	//anything still reading after that is left in reading
+	void collect(bool wait);
+	void encodeLoop();
+	void encode(const Slot& slot);
+};
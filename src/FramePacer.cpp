@@ -0,0 +1,109 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "winmm.lib") //timeBeginPeriod
+#endif
+
+FramePacer framePacer;
+
+static const double SAFETY_MARGIN = 0.002;
+static const double SPIN_TIME = 0.001; //Sleeps can overshoot by about this much even at 1 ms timer resolution, so spin the end
+
+static void sleepUntil(double time) {
+	while (true) {
+		double remaining = time - glfwGetTime();
+		if (remaining <= 0)
+			return;
+
+		if (remaining > SPIN_TIME)
+			std::this_thread::sleep_for(std::chrono::duration<double>(remaining - SPIN_TIME));
+		else
+			std::this_thread::yield();
+	}
+}
+
+void FramePacer::init(int refreshRate, bool enabled, bool report) {
+	this->enabled = enabled && refreshRate > 0;
+	this->report = report;
+	refreshInterval = refreshRate > 0 ? 1.0 / refreshRate : 0;
+
+#ifdef _WIN32
+	//Sleep() is only accurate to the timer tick, 15.6 ms by default, which is most of a frame
+	if (this->enabled)
+		timeBeginPeriod(1);
+#endif
+}
+
+double FramePacer::estimate() const {
+	double worst = 0;
+	for (int i = 0; i < workCount; i++)
+		worst = std::max(worst, workTimes[i]);
+
+	return worst + SAFETY_MARGIN;
+}
+
+void FramePacer::wait() {
+	double start = glfwGetTime();
+
+	//Nothing to predict from until the first present
+	if (enabled && lastPresent > 0)
+		sleepUntil(lastPresent + refreshInterval - estimate());
+
+	frameStart = glfwGetTime();
+	slept = frameStart - start;
+	inputTime = frameStart; //Until latchInput() says otherwise
+}
+
+void FramePacer::latchInput() {
+	inputTime = glfwGetTime();
+}
+
+void FramePacer::beginPresent() {
+	presentStart = glfwGetTime();
+
+	workTimes[workNext] = presentStart - frameStart;
+	workNext = (workNext + 1) % HISTORY;
+	workCount = std::min(workCount + 1, (int)HISTORY);
+}
+
+void FramePacer::endPresent() {
+	double now = glfwGetTime();
+
+	//More than one and a half intervals between presents means a vblank went by without a new frame
+	if (refreshInterval > 0 && lastPresent > 0 && now - lastPresent > refreshInterval * 1.5)
+		missed++;
+	lastPresent = now;
+
+	//With vsync the swap returns at about the flip, so this is close to when the input became visible
+	double latency = now - inputTime;
+	frames++;
+	latencySum += latency;
+	latencyWorst = std::max(latencyWorst, latency);
+
+	if (report) {
+		std::cout << "Frame " << frames << ": input to present " << latency * 1000 << " ms, work " << (presentStart - frameStart) * 1000
+			<< " ms, slept " << slept * 1000 << " ms\n";
+	}
+}
+
+void FramePacer::destroy() {
+	if (report && frames > 0) {
+		std::cout << "Input to present " << latencySum / frames * 1000 << " ms average, " << latencyWorst * 1000 << " ms worst over "
+			<< frames << " frames, " << missed << " missed vblanks" << (enabled ? "" : " (pacing off)") << std::endl;
+	}
+
+#ifdef _WIN32
+	if (enabled)
+		timeEndPeriod(1);
+#endif
+	enabled = false;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+//Delays the start of each frame so its work finishes just before the vblank it's going to be shown at, instead of
+//finishing early and sitting in glfwSwapBuffers for most of a frame. Input sampled at the start of the work is then
+//only about one frame's work old when it reaches the screen, rather than nearly a whole refresh interval.
+//
+//The next vblank is predicted as the last present plus the refresh interval, and the frame's cost as the worst work time
+//over the last HISTORY frames plus SAFETY_MARGIN for the GPU and scheduling noise. A frame that overruns the estimate
+//misses its vblank, which makes the next estimate bigger, so it backs off by itself after a hitch.
+struct FramePacer {
+	static const int HISTORY = 32;
+
+	bool enabled = false; //Only makes sense with vsync, otherwise nothing tells us when a present happens
+	bool report = false; //Log the estimated input to present latency every frame
+	double refreshInterval = 0; //Seconds
+
+	double workTimes[HISTORY] = {}; //Frame start to present, seconds
+	int workNext = 0, workCount = 0;
+
+	double frameStart = 0, inputTime = 0, presentStart = 0, lastPresent = 0; //glfwGetTime()
+	double slept = 0; //This frame, seconds
+
+	//Over the whole run
+	int frames = 0, missed = 0;
+	double latencySum = 0, latencyWorst = 0;
+
+	void init(int refreshRate, bool enabled, bool report);
+
+	//Sleeps until it's time to start working on the next frame, call before anything else in the frame
+	void wait();
+
+	//Call right after sampling the input the draw list will use
+	void latchInput();
+
+	//Around the present (glfwSwapBuffers), the first ends the work, the second is when it got on screen
+	void beginPresent();
+	void endPresent();
+
+	//Seconds from starting work to the buffer swap, with margin
+	double estimate() const;
+
+	//Logs the run's averages if report is set, and puts the timer resolution back
+	void destroy();
+};
+
+extern FramePacer framePacer;
@@ -0,0 +1,38 @@
+#include "Framebuffer.h"
+#include "GLState.h"
+
+#include <iostream>
+
+bool Framebuffer::init(int width, int height) {
+	this->width = width;
+	this->height = height;
+
+	glGenTextures(1, &colorTexture);
+	glState.bindTexture(0, colorTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glState.bindTexture(0, 0);
+
+	glGenFramebuffers(1, &fbo);
+	glState.bindFramebuffer(fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glState.bindFramebuffer(0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Error: Framebuffer incomplete, status: " << status << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void Framebuffer::destroy() {
+	glState.deleteFramebuffer(fbo);
+	glState.deleteTexture(colorTexture);
+	fbo = colorTexture = 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glad/glad.h>
+
+//Offscreen render target with a single RGBA8 color texture
+struct Framebuffer {
+	GLuint fbo = 0, colorTexture = 0;
+	int width = 0, height = 0;
+
+	//Returns false if the driver says the framebuffer is incomplete
+	bool init(int width, int height);
+
+	void destroy();
+};
@@ -0,0 +1,184 @@
+#include "GLRenderBackend.h"
+#include "GLState.h"
+#include "GpuProfiler.h"
+#include "ParticleSystem.h"
+
+void GLRenderBackend::init(QuadBatch* batch, StreamBuffer* stream, int viewportWidth, int viewportHeight) {
+	this->batch = batch;
+	this->stream = stream;
+	this->viewportWidth = viewportWidth;
+	this->viewportHeight = viewportHeight;
+}
+
+//Which GPU timing a command counts towards
+static GpuPass passOf(const RenderCommand& command) {
+	if (command.type == COMMAND_CLEAR)
+		return GPU_PASS_CLEAR;
+	if (command.type == COMMAND_PARTICLES)
+		return GPU_PASS_PARTICLES;
+	if (command.layer == LAYER_UI)
+		return GPU_PASS_TEXT;
+
+	return command.layer == LAYER_PLAYFIELD ? GPU_PASS_RECTS : GPU_PASS_TEXTURES;
+}
+
+static void applyBlend(BlendMode blend) {
+	switch (blend) {
+	case BLEND_OPAQUE:
+		glState.setBlend(false);
+		break;
+	case BLEND_ALPHA:
+		glState.setBlend(true);
+		glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		break;
+	case BLEND_ADDITIVE:
+		glState.setBlend(true);
+		glState.blendFunc(GL_SRC_ALPHA, GL_ONE);
+		break;
+	}
+}
+
+void GLRenderBackend::render(const std::vector<RenderCommand>& commands, const std::vector<RenderQueue::SortEntry>& order) {
+	stream->beginFrame();
+
+	GLuint targetFBO = target ? target->fbo : 0;
+	int targetWidth = target ? target->width : viewportWidth;
+	int targetHeight = target ? target->height : viewportHeight;
+
+	bool offscreen = scene && ((post && post->active()) || sceneWidth != targetWidth || sceneHeight != targetHeight);
+	if (offscreen) {
+		glState.bindFramebuffer(scene->fbo);
+		glViewport(0, 0, sceneWidth, sceneHeight);
+	}
+	else {
+		glState.bindFramebuffer(targetFBO);
+		glViewport(0, 0, targetWidth, targetHeight);
+	}
+
+	//State of the quads currently in the batch, the batch is flushed whenever it changes
+	bool first = true;
+	BlendMode blend = BLEND_OPAQUE;
+	GLuint program = 0, texture = 0;
+	GpuPass pass = GPU_PASS_COUNT;
+
+	for (const RenderQueue::SortEntry& entry : order) {
+		const RenderCommand& command = commands[entry.index];
+
+		if (offscreen && command.layer >= LAYER_UI) {
+			//Scene's done, put it on the target and draw the UI at full resolution on top
+			batch->flush();
+			finishScene(targetFBO, targetWidth, targetHeight);
+			offscreen = false;
+
+			//Post changes state behind our back
+			first = true;
+			pass = GPU_PASS_COUNT;
+		}
+
+		//Sorted by layer first, so each pass is mostly one run of commands
+		GpuPass commandPass = passOf(command);
+		if (commandPass != pass) {
+			if (gpuProfiler.enabled)
+				batch->flush(); //The quads so far belong to the last pass, otherwise they keep batching across it
+			gpuProfiler.begin(commandPass);
+			pass = commandPass;
+		}
+
+		if (command.type == COMMAND_CLEAR) {
+			batch->flush();
+			glClearColor(command.r, command.g, command.b, command.a);
+			glClear(GL_COLOR_BUFFER_BIT);
+			continue;
+		}
+
+		if (first || command.blend != blend || command.program != program || command.texture != texture) {
+			batch->flush();
+
+			applyBlend(command.blend);
+			glState.useProgram(command.program);
+			if (command.texture)
+				glState.bindTexture(0, command.texture);
+
+			first = false;
+			blend = command.blend;
+			program = command.program;
+			texture = command.texture;
+		}
+
+		if (command.type == COMMAND_PARTICLES) {
+			batch->flush();
+			command.particles->draw();
+			continue;
+		}
+
+		if (command.type == COMMAND_QUAD_LIST) {
+			batch->draw(*command.list); //Anything queued has the list's state and was sorted before it
+			continue;
+		}
+
+		batch->add(command.x, command.y, command.width, command.height, command.r, command.g, command.b, command.a,
+			command.u0, command.v0, command.u1, command.v1);
+	}
+
+	batch->flush();
+	if (offscreen)
+		finishScene(targetFBO, targetWidth, targetHeight); //No UI this frame
+	gpuProfiler.end();
+
+	stream->endFrame();
+}
+
+void GLRenderBackend::finishScene(GLuint targetFBO, int targetWidth, int targetHeight) {
+	if (post && post->active()) {
+		post->apply(*scene, sceneWidth, sceneHeight, targetFBO, targetWidth, targetHeight);
+		return;
+	}
+
+	gpuProfiler.begin(GPU_PASS_UPSCALE);
+
+	//glState tracks draw and read together, so put read back to match once we're done with it
+	glState.bindFramebuffer(targetFBO);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, scene->fbo);
+	glBlitFramebuffer(0, 0, sceneWidth, sceneHeight, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, targetFBO);
+
+	glViewport(0, 0, targetWidth, targetHeight);
+}
+
+void GLRenderBackend::present(GLFWwindow* window) {
+	glState.endFrame();
+
+	if (swap)
+		glfwSwapBuffers(window); //Updates screen, we write to one buffer, while we display the other
+	else
+		glFlush(); //Nothing to swap, just make sure the frame gets to the GPU
+}
+
+GLuint GLRenderBackend::createTexture(int width, int height) {
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glState.bindTexture(0, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	//Storage starts out undefined, clear it so unused parts of an atlas are transparent
+	glClearTexImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	return texture;
+}
+
+void GLRenderBackend::updateTexture(GLuint texture, int x, int y, int width, int height, const uint32_t* pixels, int stride) {
+	glState.bindTexture(0, texture);
+	glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void GLRenderBackend::destroyTexture(GLuint texture) {
+	glState.deleteTexture(texture);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "QuadBatch.h"
+#include "StreamBuffer.h"
+#include "Framebuffer.h"
+#include "PostProcess.h"
+
+//Replays commands through QuadBatch, flushing only when blend, program or texture changes
+struct GLRenderBackend : RenderBackend {
+	QuadBatch* batch = nullptr;
+	StreamBuffer* stream = nullptr;
+	Framebuffer* target = nullptr; //Where frames are drawn, nullptr for the window
+	int viewportWidth = 0, viewportHeight = 0; //Size of the window's framebuffer
+	bool swap = true; //False when there's no visible window to swap
+
+	//Everything under LAYER_UI is drawn into the bottom left sceneWidth x sceneHeight of scene, then put on the target
+	//through post, or stretched over it if there are no effects, before the UI is drawn. With no effects at full size
+	//that's skipped and the scene goes straight to target. DynamicResolution picks the size
+	Framebuffer* scene = nullptr;
+	int sceneWidth = 0, sceneHeight = 0;
+	PostProcess* post = nullptr;
+
+	void init(QuadBatch* batch, StreamBuffer* stream, int viewportWidth, int viewportHeight);
+
+	void render(const std::vector<RenderCommand>& commands, const std::vector<RenderQueue::SortEntry>& order) override;
+
+	//Puts the used part of scene on the target, through post if it's active, and leaves the target bound
+	void finishScene(GLuint targetFBO, int targetWidth, int targetHeight);
+	void present(GLFWwindow* window) override;
+
+	GLuint createTexture(int width, int height) override;
+	void updateTexture(GLuint texture, int x, int y, int width, int height, const uint32_t* pixels, int stride) override;
+	void destroyTexture(GLuint texture) override;
+};
@@ -0,0 +1,161 @@
+#include "GLState.h"
+
+GLState glState;
+
+//Index into GLState::buffers, or -1 for targets we don't track
+static int bufferTargetIndex(GLenum target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER: return 0;
+	case GL_PIXEL_PACK_BUFFER: return 1;
+	case GL_PIXEL_UNPACK_BUFFER: return 2;
+	case GL_UNIFORM_BUFFER: return 3;
+	case GL_SHADER_STORAGE_BUFFER: return 4;
+	case GL_DRAW_INDIRECT_BUFFER: return 5;
+	case GL_COPY_READ_BUFFER: return 6;
+	case GL_COPY_WRITE_BUFFER: return 7;
+	default: return -1; //GL_ELEMENT_ARRAY_BUFFER is part of the VAO, so it can't be cached here
+	}
+}
+
+void GLState::useProgram(GLuint program) {
+	if (this->program == program) {
+		frame.elided++;
+		return;
+	}
+
+	glUseProgram(program);
+	this->program = program;
+	frame.issued++;
+}
+
+void GLState::bindVertexArray(GLuint vertexArray) {
+	if (this->vertexArray == vertexArray) {
+		frame.elided++;
+		return;
+	}
+
+	glBindVertexArray(vertexArray);
+	this->vertexArray = vertexArray;
+	frame.issued++;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+	int index = bufferTargetIndex(target);
+	if (index >= 0 && buffers[index] == buffer) {
+		frame.elided++;
+		return;
+	}
+
+	glBindBuffer(target, buffer);
+	if (index >= 0)
+		buffers[index] = buffer;
+	frame.issued++;
+}
+
+void GLState::bindTexture(int unit, GLuint texture) {
+	if (textures[unit] == texture) {
+		frame.elided++;
+		return;
+	}
+
+	GLenum unitEnum = GL_TEXTURE0 + unit;
+	if (activeUnit != unitEnum) {
+		glActiveTexture(unitEnum);
+		activeUnit = unitEnum;
+		frame.issued++;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	textures[unit] = texture;
+	frame.issued++;
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer) {
+	if (this->framebuffer == framebuffer) {
+		frame.elided++;
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	this->framebuffer = framebuffer;
+	frame.issued++;
+}
+
+void GLState::setBlend(bool enabled) {
+	if (blendEnabled == enabled) {
+		frame.elided++;
+		return;
+	}
+
+	if (enabled) glEnable(GL_BLEND);
+	else glDisable(GL_BLEND);
+	blendEnabled = enabled;
+	frame.issued++;
+}
+
+void GLState::blendFunc(GLenum src, GLenum dst) {
+	if (blendSrc == src && blendDst == dst) {
+		frame.elided++;
+		return;
+	}
+
+	glBlendFunc(src, dst);
+	blendSrc = src;
+	blendDst = dst;
+	frame.issued++;
+}
+
+void GLState::deleteProgram(GLuint program) {
+	if (this->program == program)
+		this->program = 0;
+	glDeleteProgram(program);
+}
+
+void GLState::deleteVertexArray(GLuint vertexArray) {
+	if (this->vertexArray == vertexArray)
+		this->vertexArray = 0;
+	glDeleteVertexArrays(1, &vertexArray);
+}
+
+void GLState::deleteBuffer(GLuint buffer) {
+	for (int i = 0; i < BUFFER_TARGETS; i++) {
+		if (buffers[i] == buffer)
+			buffers[i] = 0;
+	}
+	glDeleteBuffers(1, &buffer);
+}
+
+void GLState::deleteTexture(GLuint texture) {
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
+		if (textures[i] == texture)
+			textures[i] = 0;
+	}
+	glDeleteTextures(1, &texture);
+}
+
+void GLState::deleteFramebuffer(GLuint framebuffer) {
+	if (this->framebuffer == framebuffer)
+		this->framebuffer = 0;
+	glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GLState::invalidate() {
+	//Values no real object uses, so the next call of each kind never matches
+	const GLuint UNKNOWN = 0xFFFFFFFF;
+
+	program = vertexArray = framebuffer = UNKNOWN;
+	for (int i = 0; i < BUFFER_TARGETS; i++)
+		buffers[i] = UNKNOWN;
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+		textures[i] = UNKNOWN;
+	activeUnit = UNKNOWN;
+	blendSrc = blendDst = UNKNOWN;
+
+	//Blend is a bool, so read it back instead
+	blendEnabled = glIsEnabled(GL_BLEND) == GL_TRUE;
+}
+
+void GLState::endFrame() {
+	lastFrame = frame;
+	frame = GLStateStats();
+}
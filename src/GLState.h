@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+
+//Counts of state changes that reached the driver vs ones we dropped because nothing would have changed
+struct GLStateStats {
+	int issued = 0, elided = 0;
+};
+
+//Thin cache in front of the glad entry points for the state we change often. Redundant binds are expensive on
+//software and virtualized drivers, so every program, VAO, buffer, texture and blend change should go through here.
+//Anything that changes this state with raw GL calls has to call invalidate() afterwards.
+struct GLState {
+	static const int MAX_TEXTURE_UNITS = 16;
+	static const int BUFFER_TARGETS = 8; //See bufferTargetIndex() in GLState.cpp
+
+	GLuint program = 0, vertexArray = 0, framebuffer = 0;
+	GLuint buffers[BUFFER_TARGETS] = {};
+	GLuint textures[MAX_TEXTURE_UNITS] = {}; //Only GL_TEXTURE_2D is tracked
+	GLenum activeUnit = GL_TEXTURE0;
+	bool blendEnabled = false;
+	GLenum blendSrc = GL_ONE, blendDst = GL_ZERO; //GL defaults
+
+	GLStateStats frame; //Counts for the frame in progress
+	GLStateStats lastFrame; //Counts for the last finished frame, shown and logged with --gpu-times
+
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vertexArray);
+	void bindBuffer(GLenum target, GLuint buffer);
+	void bindTexture(int unit, GLuint texture); //Binds to GL_TEXTURE_2D on GL_TEXTURE0 + unit
+	void bindFramebuffer(GLuint framebuffer); //Binds to GL_FRAMEBUFFER, so both draw and read
+	void setBlend(bool enabled);
+	void blendFunc(GLenum src, GLenum dst);
+
+	//Deleting a bound object unbinds it in GL, so deletes go through here to keep the cache honest
+	void deleteProgram(GLuint program);
+	void deleteVertexArray(GLuint vertexArray);
+	void deleteBuffer(GLuint buffer);
+	void deleteTexture(GLuint texture);
+	void deleteFramebuffer(GLuint framebuffer);
+
+	//Forget everything, the next call of each kind is always issued
+	void invalidate();
+
+	//Moves this frame's counts to lastFrame and starts counting again
+	void endFrame();
+};
+
+extern GLState glState;
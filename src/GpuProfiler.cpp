@@ -0,0 +1,142 @@
+#include "GpuProfiler.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+GpuProfiler gpuProfiler;
+
+//Indexed by GpuPass
+static const char* PASS_NAMES[GPU_PASS_COUNT] = { "clear", "rects", "textures", "text", "particles", "upscale", "bloom", "post" };
+
+const char* GpuProfiler::passName(GpuPass pass) {
+	return PASS_NAMES[pass];
+}
+
+void GpuProfiler::init() {
+	//Allowed to be 0, in which case timestamps are meaningless
+	GLint bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+	if (bits == 0) {
+		std::cout << "Error: GL_TIMESTAMP has no counter bits, GPU timings are off" << std::endl;
+		return;
+	}
+
+	for (Frame& frame : frames)
+		glGenQueries(MAX_SCOPES * 2, frame.queries);
+	enabled = true;
+}
+
+void GpuProfiler::beginFrame() {
+	if (!enabled)
+		return;
+
+	Frame& frame = frames[current];
+	if (frame.pending) {
+		//The last end query finishes last, if it's there they all are
+		GLuint available = 0;
+		if (frame.scopes > 0)
+			glGetQueryObjectuiv(frame.queries[frame.scopes * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available) {
+			lastFrame = 0;
+			for (int i = 0; i < frame.scopes; i++) {
+				GLuint64 start = 0, end = 0;
+				glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+				glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+				double ms = (end - start) / 1e6;
+				sums[frame.passes[i]] += ms;
+				totals[frame.passes[i]] += ms;
+				lastFrame += (float)ms;
+			}
+			sumFrames++;
+			totalFrames++;
+		}
+		else if (frame.scopes > 0)
+			dropped++;
+	}
+
+	frame.scopes = 0;
+	frame.pending = false;
+	open = false;
+}
+
+void GpuProfiler::endFrame() {
+	if (!enabled)
+		return;
+
+	end();
+	frames[current].pending = true;
+	current = (current + 1) % FRAMES_IN_FLIGHT;
+}
+
+void GpuProfiler::begin(GpuPass pass) {
+	if (!enabled)
+		return;
+
+	end();
+
+	Frame& frame = frames[current];
+	if (frame.scopes >= MAX_SCOPES)
+		return;
+
+	frame.passes[frame.scopes] = pass;
+	glQueryCounter(frame.queries[frame.scopes * 2], GL_TIMESTAMP);
+	open = true;
+}
+
+void GpuProfiler::end() {
+	if (!enabled || !open)
+		return;
+
+	Frame& frame = frames[current];
+	glQueryCounter(frame.queries[frame.scopes * 2 + 1], GL_TIMESTAMP);
+	frame.scopes++;
+	open = false;
+}
+
+void GpuProfiler::publish(bool log) {
+	if (!enabled || sumFrames == 0)
+		return;
+
+	averageTotal = 0;
+	for (int i = 0; i < GPU_PASS_COUNT; i++) {
+		average[i] = (float)(sums[i] / sumFrames);
+		averageTotal += average[i];
+		sums[i] = 0;
+	}
+	sumFrames = 0;
+	version++;
+
+	if (log)
+		std::cout << summary() << std::endl;
+}
+
+std::string GpuProfiler::summary() const {
+	std::ostringstream text;
+	text << std::fixed << std::setprecision(2) << "GPU " << averageTotal << " ms (";
+	for (int i = 0; i < GPU_PASS_COUNT; i++)
+		text << (i > 0 ? " " : "") << PASS_NAMES[i] << " " << average[i];
+	text << ")";
+
+	return text.str();
+}
+
+void GpuProfiler::destroy() {
+	if (!enabled)
+		return;
+
+	if (totalFrames > 0) {
+		std::cout << "GPU averages over " << totalFrames << " frames (" << dropped << " dropped):";
+		for (int i = 0; i < GPU_PASS_COUNT; i++)
+			std::cout << " " << PASS_NAMES[i] << " " << totals[i] / totalFrames << " ms";
+		std::cout << std::endl;
+	}
+
+	for (Frame& frame : frames) {
+		glDeleteQueries(MAX_SCOPES * 2, frame.queries);
+		frame = Frame();
+	}
+	enabled = false;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glad/glad.h>
+
+//What a GPU scope's time is put down to
+enum GpuPass {
+	GPU_PASS_CLEAR,
+	GPU_PASS_RECTS, //LAYER_PLAYFIELD, the paddles and ball
+	GPU_PASS_TEXTURES, //Texture and atlas uploads, plus any other quads outside the UI
+	GPU_PASS_TEXT, //Everything on LAYER_UI, which is only text for now
+	GPU_PASS_PARTICLES,
+	GPU_PASS_UPSCALE, //Dynamic resolution's blit of the scene up to the window
+	GPU_PASS_BLOOM, //PostProcess's downsample chain, all below half resolution
+	GPU_PASS_POST, //PostProcess's fused pass, every effect plus the upscale
+	GPU_PASS_COUNT
+};
+
+//GPU time per pass from GL_TIMESTAMP queries. Every scope is a pair of glQueryCounter calls, and each frame's queries
+//live in one slot of a ring, so by the time a slot comes round again its results are FRAMES_IN_FLIGHT frames old and
+//normally already there. If they aren't, that frame is dropped instead of waiting, reading early would stall the CPU
+//on the GPU and hide exactly what we're trying to measure.
+//Only the time between begin() and end() counts, GPU idle time between scopes doesn't show up anywhere.
+struct GpuProfiler {
+	static const int FRAMES_IN_FLIGHT = 4;
+	static const int MAX_SCOPES = 32; //Per frame, any more are ignored
+
+	struct Frame {
+		GLuint queries[MAX_SCOPES * 2] = {}; //Start and end of each scope
+		GpuPass passes[MAX_SCOPES] = {};
+		int scopes = 0;
+		bool pending = false; //Issued, results not read yet
+	};
+
+	bool enabled = false; //init() was called and the driver has a timestamp counter
+	Frame frames[FRAMES_IN_FLIGHT];
+	int current = 0;
+	bool open = false; //A scope was begun and not ended
+
+	//Summed since the last publish(), and over the whole run
+	double sums[GPU_PASS_COUNT] = {}, totals[GPU_PASS_COUNT] = {};
+	int sumFrames = 0, totalFrames = 0, dropped = 0;
+
+	float lastFrame = 0; //Ms, every pass of the most recent frame read back, for things that react per frame
+
+	//Average ms per frame as of the last publish()
+	float average[GPU_PASS_COUNT] = {};
+	float averageTotal = 0;
+	uint32_t version = 0; //Bumped by publish()
+
+	//Needs the GL context
+	void init();
+
+	//Reads back the slot about to be reused, call once at the start of a frame before anything is drawn
+	void beginFrame();
+	void endFrame();
+
+	//Ends any open scope and starts one for pass
+	void begin(GpuPass pass);
+	void end();
+
+	//Averages what's been read back since the last call, and logs it if log is set
+	void publish(bool log);
+
+	//One line, "GPU 0.42 ms (clear 0.01 ...)"
+	std::string summary() const;
+
+	//Logs the averages over the whole run and deletes the queries
+	void destroy();
+
+	static const char* passName(GpuPass pass);
+};
+
+extern GpuProfiler gpuProfiler;
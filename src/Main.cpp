@@ -1,20 +1,41 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <string>
 #include <cstring>
 #include <map>
+#include <thread>
+#include <chrono>
+#include <cmath>
 
 #include <glad/glad.h> //Make to sure to include glad.c in project!
 #include <GLFW/glfw3.h>
 //#include <glm/glm.hpp> //From https://github.com/g-truc/glm
 
-//FreeType: https://freetype.org/freetype2/docs/tutorial/step1.html
-#include <freetype/config/ftheader.h>
-#include <freetype/freetype.h>
-#include FT_FREETYPE_H
-
-#include <stb/stb_image.h>
+#include "GLState.h"
+#include "StreamBuffer.h"
+#include "QuadBatch.h"
+#include "RenderQueue.h"
+#include "Framebuffer.h"
+#include "GLRenderBackend.h"
+#include "SoftwareRenderer.h"
+#include "ThreadPool.h"
+#include "FrameCapture.h"
+#include "Texture.h"
+#include "TextureAtlas.h"
+#include "AssetManager.h"
+#include "ShaderCache.h"
+#include "ShaderBuilder.h"
+#include "ShaderPermutations.h"
+#include "TextRenderer.h"
+#include "TextLayout.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include "FramePacer.h"
+#include "DynamicResolution.h"
+#include "PostProcess.h"
+#include "ParticleSystem.h"
 
 using namespace std;
 
@@ -23,60 +44,64 @@ GLFWwindow* window;
 void error(int error, const char* desc);
 static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void updateScreen();
-string readFile(string file);
-int initShaders();
-GLuint genVAO(float *vertices);
-void draw(float *vertices);
+void initShaders();
+int finishShaders();
 void moveBall();
 void handleKeys();
 void resetGame();
+void updateTextures();
 
 const int SCREEN_WIDTH = 1920, SCREEN_HEIGHT = 1080; //Screen size
 
-struct Texture {
-	int width = 0, height = 0, colorChannels;
-	unsigned char* bytes;
-	GLuint textureID = 0;
-
-	Texture(string file, int width, int height, int channels) {
-		this->width = width;
-		this->height = height;
-		this->colorChannels = channels;
+Texture testTexture("resources/acererak.png");
+TextureAtlas uiAtlas; //Glyphs and other small runtime images, one texture for the whole HUD and playfield
+shared_ptr<FontAsset> hudFont; //Rasterized on the pool while the window comes up
 
-		bytes = stbi_load(file.c_str(), &width, &height, &channels, 0);
-	}
+//Every shader source initShaders() needs, read ahead of time so compiling doesn't wait on the disk
+const char* SHADER_FILES[] = { "src/shaders/vertex.vert", "src/shaders/fragment.frag",
+	"src/shaders/post.vert", "src/shaders/bloom.frag", "src/shaders/post.frag", "src/shaders/particle.vert",
+	"src/shaders/particle.frag" };
 
-	Texture() { } //Default constructor
+StreamBuffer streamBuffer; //All per-frame geometry is uploaded through this
+QuadBatch quadBatch; //glBackend draws every quad in a frame through this
 
-	void generate() {
-		//Create the texture
-		glGenTextures(1, &textureID);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, textureID);
+ThreadPool threadPool;
+GLRenderBackend glBackend;
+SoftwareRenderer softwareRenderer; //Used instead of GL with --software
+RenderBackend* renderBackend; //Whichever of the two we're using
+bool softwareRendering = false;
 
-		//Configure the texture
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+//Headless mode, --headless. No visible window, frames go to offscreenTarget and the loop runs as fast as it can
+bool headless = false;
+int frameLimit = 0; //--frames N, stop after N frames, 0 for no limit
+Framebuffer offscreenTarget;
+const float HEADLESS_STEP = 1.0f / 60.0f; //Simulated time per frame in headless mode, so runs are repeatable
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+//--capture file.y4m records every frame
+string capturePath;
+FrameCapture frameCapture;
 
-		//Generate the texture
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes);
+//--gpu-times logs GPU time per pass and shows it under the FPS, next to CPU time so it's clear which one a slow frame waited on.
+//GL state changes that reached the driver, out of all that were asked for, go with it
+bool gpuTimes = false;
+double cpuTimeSum = 0; //Seconds of CPU work per frame, up to present, since the last publish
+int cpuTimeFrames = 0;
+TextLayout gpuTimesText;
 
-		//Clean up
-		stbi_image_free(bytes);
-		glBindTexture(GL_TEXTURE_2D, 0);
+//Pacing is on whenever we're vsynced, --no-pacing turns it off to compare. --latency logs input to present every frame
+bool pacing = true, latencyReport = false;
 
-		//Generate mipmap
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-};
+//--dynamic-resolution draws the playfield smaller when GPU time goes over budget, down to MIN_RESOLUTION_SCALE
+bool dynamicResolutionEnabled = false;
+const float MIN_RESOLUTION_SCALE = 0.5f;
+const float GPU_BUDGET = 0.9f; //Of the refresh interval
 
-Texture testTexture = Texture("resources/acererak.png", 2000, 1319, 3);
+//--crt, --bloom and --scanlines turn on post effects, --post turns on all of them. GL only
+uint32_t postFeatures = 0;
+Framebuffer sceneTarget; //The playfield is drawn here when it's scaled or post processed
 
-GLuint shaderProgram, textShader; //Unsigned int
-GLuint vao; //VertexAttribObject, stores our vertex config
+//--trace file.json writes a Chrome trace of the run, only in builds with PONG_PROFILE defined
+string tracePath;
 
 struct Vector2 {
 	float x = 0, y = 0;
@@ -95,30 +120,12 @@ struct Vector2 {
 struct Rect {
 	float x = 0, y = 0, width = 0, height = 0;
 
-	float** vertices() {
-		static float** verts = 0; //2D array
-
-		verts = new float*[2];
-
-		verts[0] = new float[9]{ 
-			x, y, 0,
-			x + width, y, 0,
-			x, y + height, 0
-		};
-
-		verts[1] = new float[9] {
-			x + width, y, 0,
-				x + width, y + height, 0,
-				x, y + height, 0
-		};
-
-		return verts;
-	}
-
 	void drawSelf() {
-		float** verts = vertices();
-		draw(verts[0]);
-		draw(verts[1]);
+		//The atlas's white patch through the glyphs' quad variant is a solid quad. Sharing the HUD's program and texture
+		//means the paddles, ball and text all batch into one draw
+		const AtlasRegion& white = uiAtlas.white;
+		renderQueue.drawTexturedQuad(LAYER_PLAYFIELD, textRenderer.program(*hudFont), uiAtlas.textureID, x, y, width, height,
+			white.u0, white.v0, white.u1, white.v1);
 	}
 
 	//Create a constructor to populate variables and halve the width
@@ -161,71 +168,328 @@ const int W = 87, S = 83, UP = 265, DOWN = 264;
 float leftDir = 0, rightDir = 0;
 
 int leftScore = 0, rightScore = 0;
+uint32_t scoreVersion = 0; //Bumped whenever a score changes so the score text knows to lay out again
+TextLayout leftScoreText, rightScoreText, fpsText;
+TextGroup hudText; //Every string above, and gpuTimesText, in one draw
+
+float fps = 0; //Averaged over FPS_INTERVAL, shown in the corner
+uint32_t fpsVersion = 0; //Bumped every time fps is worked out
+const double FPS_INTERVAL = 0.5;
+
+//Ball trail and sparks off the paddles and walls. --particles N keeps N alive across the screen as a stress test
+const int PARTICLE_CAPACITY = 65536;
+const int IMPACT_SPARKS = 200; //Per bounce
+const float TRAIL_RATE = 240.0f; //Particles per second, so the trail looks the same at any frame rate
+const float PI = 3.14159265f;
+float trailRemainder = 0; //Fraction of a trail particle carried over to the next frame
+int stressParticles = 0;
+void emitStressParticles();
+
+int main(int argc, char** argv) {
+	PROFILE_THREAD("main");
+	int contextAPI = GLFW_NATIVE_CONTEXT_API;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--software") == 0) softwareRendering = true; //Draw on the CPU, no GL needed
+		else if (strcmp(argv[i], "--headless") == 0) headless = true;
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frameLimit = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) capturePath = argv[++i];
+		else if (strcmp(argv[i], "--gpu-times") == 0) gpuTimes = true;
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) tracePath = argv[++i];
+		else if (strcmp(argv[i], "--no-pacing") == 0) pacing = false;
+		else if (strcmp(argv[i], "--latency") == 0) latencyReport = true;
+		else if (strcmp(argv[i], "--dynamic-resolution") == 0) dynamicResolutionEnabled = true;
+		else if (strcmp(argv[i], "--particles") == 0 && i + 1 < argc) stressParticles = max(0, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--crt") == 0) postFeatures |= SHADER_CRT;
+		else if (strcmp(argv[i], "--bloom") == 0) postFeatures |= SHADER_BLOOM;
+		else if (strcmp(argv[i], "--scanlines") == 0) postFeatures |= SHADER_SCANLINES;
+		else if (strcmp(argv[i], "--post") == 0) postFeatures |= SHADER_CRT | SHADER_BLOOM | SHADER_SCANLINES;
+		else if (strcmp(argv[i], "--context") == 0 && i + 1 < argc) {
+			//egl works with Mesa llvmpipe without a display server, osmesa doesn't need a window system at all
+			i++;
+			if (strcmp(argv[i], "egl") == 0) contextAPI = GLFW_EGL_CONTEXT_API;
+			else if (strcmp(argv[i], "osmesa") == 0) contextAPI = GLFW_OSMESA_CONTEXT_API;
+		}
+	}
+
+	//Start on everything that comes off the disk now, so it happens while GLFW and glad are busy
+#if !defined(_WIN32) && !defined(__linux__)
+	if (softwareRendering && !headless) {
+		//SoftwareRenderer::present() only knows GDI and X11, the window would stay black
+		cout << "Error: --software can't show a window on this platform, use it with --headless" << endl;
+		return 1;
+	}
+#endif
+
+	threadPool.start();
+	assetManager.init(&threadPool);
+	if (assetManager.mount("resources.pak")) //Made by TextureCooker --pack, loose files are used without it
+		cout << "Loading assets from resources.pak" << endl;
+	for (const char* file : SHADER_FILES)
+		assetManager.loadFile(file);
+	//One distance field at a small size covers every size we draw at. The software renderer samples nearest and has
+	//no shaders, so it gets plain coverage at about the size the scores are drawn
+	if (softwareRendering)
+		hudFont = assetManager.loadFont("resources/fonts/ARIAL.TTF", 96);
+	else
+		hudFont = assetManager.loadFont("resources/fonts/ARIAL.TTF", 32, true);
+	{
+		PROFILE_SCOPE("testTexture.load");
+		testTexture.load(assetManager, !softwareRendering); //updateTextures() finishes it off over the next few frames
+	}
 
-int main() {
-	if (!glfwInit()) {
+	bool glfwReady;
+	{
+		PROFILE_SCOPE("glfwInit");
+		glfwReady = glfwInit() == GLFW_TRUE;
+	}
+	if (!glfwReady) {
 		//Failed to init GLFW
 		return 1;
 	}
 
 	glfwSetErrorCallback(error);
 
-	//Enforce minimum OpenGL versions
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (softwareRendering) {
+		//No context at all, SoftwareRenderer blits straight to the window
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	}
+	else {
+		//Enforce minimum OpenGL versions
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextAPI);
+	}
 
-	//Create window and context, getPrimaryMonitor makes it fullscreen
-	window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Pong", glfwGetPrimaryMonitor(), NULL);
+	if (headless) {
+		//Hidden windowed mode, the window only exists to own the context
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Pong", NULL, NULL);
+	}
+	else {
+		//Create window and context, getPrimaryMonitor makes it fullscreen
+		window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Pong", glfwGetPrimaryMonitor(), NULL);
+	}
 
 	if (!window) {
 		//Failed to create window
 		return 2;
 	}
 
-	//Make the window the current context
-	glfwMakeContextCurrent(window);
-
-	//Init GLAD
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-		//Failed to init GLAD
-		return 3;
-	}
-
 	glfwSetKeyCallback(window, keyCallback);
 
-	//Retrieve window size
-	int width, height;
-	glfwGetFramebufferSize(window, &width, &height);
-	glViewport(0, 0, width, height);
-
-	glfwSwapInterval(1);
+	//The fullscreen window is on the primary monitor, 0 if we can't tell
+	GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+	const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : NULL;
+	int refreshRate = mode ? mode->refreshRate : 0;
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	if (softwareRendering) {
+		softwareRenderer.init(SCREEN_WIDTH, SCREEN_HEIGHT, &threadPool);
+		renderBackend = &softwareRenderer;
+	}
+	else {
+		//Make the window the current context
+		glfwMakeContextCurrent(window);
+
+		//Init GLAD
+		bool gladReady;
+		{
+			PROFILE_SCOPE("gladLoadGLLoader");
+			gladReady = gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+		}
+		if (!gladReady) {
+			//Failed to init GLAD
+			return 3;
+		}
+
+		initShaders(); //Only starts them, they finish in the background until finishShaders()
+
+		//Dynamic resolution is driven by its timings, and post effects log what they cost at exit
+		if (gpuTimes || dynamicResolutionEnabled || postFeatures)
+			gpuProfiler.init();
+
+		//Retrieve window size
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		glViewport(0, 0, width, height);
+
+		glfwSwapInterval(headless ? 0 : 1); //Uncapped when headless
+
+		glState.setBlend(true);
+		glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		glEnable(GL_TEXTURE_2D);
+
+		streamBuffer.init(4 * 1024 * 1024); //4 MB per frame
+		quadBatch.init(65536, &streamBuffer);
+		glBackend.init(&quadBatch, &streamBuffer, width, height);
+		renderBackend = &glBackend;
+
+		if (headless) {
+			//The hidden window's own framebuffer isn't guaranteed to keep its pixels, so draw somewhere that does
+			if (!offscreenTarget.init(SCREEN_WIDTH, SCREEN_HEIGHT))
+				return 4;
+			glBackend.target = &offscreenTarget;
+			glBackend.swap = false;
+		}
+
+		int targetWidth = glBackend.target ? glBackend.target->width : width;
+		int targetHeight = glBackend.target ? glBackend.target->height : height;
+
+		if ((dynamicResolutionEnabled && gpuProfiler.enabled) || postFeatures) {
+			//Full size, dynamic resolution only ever uses less of it
+			if (!sceneTarget.init(targetWidth, targetHeight) || !postProcess.init(targetWidth, targetHeight, postFeatures))
+				return 5;
+			glBackend.scene = &sceneTarget;
+			glBackend.sceneWidth = targetWidth;
+			glBackend.sceneHeight = targetHeight;
+			glBackend.post = &postProcess;
+		}
+
+		if (dynamicResolutionEnabled && gpuProfiler.enabled)
+			dynamicResolution.init(targetWidth, targetHeight, GPU_BUDGET * 1000.0f / (refreshRate > 0 ? refreshRate : 60), MIN_RESOLUTION_SCALE);
+	}
 
-	glEnable(GL_TEXTURE_2D);
+	particles.init(PARTICLE_CAPACITY + stressParticles, (float)SCREEN_HEIGHT / SCREEN_WIDTH, &threadPool, !softwareRendering);
+
+	uiAtlas.init(1024, 1024, renderBackend);
+	textRenderer.init(&uiAtlas, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+	//Scores either side of the middle and FPS in the corner
+	leftScoreText.init(*hudFont, SCREEN_WIDTH / 2 - 80.0f, SCREEN_HEIGHT - 120.0f, 96.0f, TEXT_RIGHT);
+	rightScoreText.init(*hudFont, SCREEN_WIDTH / 2 + 80.0f, SCREEN_HEIGHT - 120.0f, 96.0f, TEXT_LEFT);
+	fpsText.init(*hudFont, 16.0f, 16.0f, 20.0f, TEXT_LEFT, 1.0f, 1.0f, 0.0f);
+	gpuTimesText.init(*hudFont, 16.0f, 44.0f, 20.0f, TEXT_LEFT, 0.0f, 1.0f, 1.0f);
+
+	if (!capturePath.empty()) {
+		//Headless frames are HEADLESS_STEP apart in game time, otherwise they come at about the refresh rate
+		int captureRate = headless ? (int)(1.0f / HEADLESS_STEP + 0.5f) : (refreshRate > 0 ? refreshRate : 60);
+		bool started;
+		if (softwareRendering)
+			started = frameCapture.start(capturePath, softwareRenderer.width, softwareRenderer.height, captureRate, false);
+		else if (glBackend.target)
+			started = frameCapture.start(capturePath, glBackend.target->width, glBackend.target->height, captureRate, true);
+		else
+			started = frameCapture.start(capturePath, glBackend.viewportWidth, glBackend.viewportHeight, captureRate, true);
+
+		if (!started)
+			capturePath.clear();
+	}
 
-	int shadersInitted = initShaders();
-	if (shadersInitted != 0) {
+	if (!softwareRendering && finishShaders() != 0) {
 		cout << "Failed to init shaders";
 		return 7;
 	}
 
 	lastTime = glfwGetTime(); //Gets the time since init
+	double startTime = lastTime, fpsTime = lastTime;
+	int frames = 0, fpsFrames = 0;
 
 	resetGame();
 
-	while (!glfwWindowShouldClose(window))
+	//Only a visible GL window is vsynced
+	framePacer.init(refreshRate, pacing && !headless && !softwareRendering, latencyReport);
+
+	while (!glfwWindowShouldClose(window) && (frameLimit == 0 || frames < frameLimit))
 	{
+		framePacer.wait();
+
 		deltaTime = glfwGetTime() - lastTime; //Time since last frame
 		lastTime = glfwGetTime();
+		if (headless)
+			deltaTime = HEADLESS_STEP;
 
 		//Main loop
-		glfwPollEvents();
-		handleKeys();
+		PROFILE_SCOPE("frame");
+		{
+			PROFILE_SCOPE("glfwPollEvents");
+			glfwPollEvents();
+		}
+		gpuProfiler.beginFrame();
+		updateTextures();
 		moveBall();
+		{
+			PROFILE_SCOPE("particles.update");
+			emitStressParticles();
+			particles.update(deltaTime);
+		}
+		{
+			//Late latch, keys that came in while we simulated still make this frame. The ball collides with
+			//where the paddles were drawn last frame, which is what the players saw anyway
+			PROFILE_SCOPE("latchInput");
+			glfwPollEvents();
+			framePacer.latchInput();
+		}
+		handleKeys();
+		dynamicResolution.update(glBackend); //Picks this frame's scene size from the GPU times read back so far
 		updateScreen();
+		gpuProfiler.endFrame();
+		frames++;
+
+		fpsFrames++;
+		if (glfwGetTime() - fpsTime >= FPS_INTERVAL) {
+			fps = (float)(fpsFrames / (glfwGetTime() - fpsTime));
+			fpsVersion++;
+			gpuProfiler.publish(gpuTimes);
+			if (gpuTimes && gpuProfiler.enabled) {
+				//How much GLState saved, from the last frame
+				cout << "GL state changes " << glState.lastFrame.issued << " issued, " << glState.lastFrame.elided << " elided" << endl;
+			}
+			fpsTime = glfwGetTime();
+			fpsFrames = 0;
+		}
+
+		if (frames == 1) {
+			cout << "First frame after " << assetManager.elapsed() * 1000 << " ms" << endl;
+			assetManager.report();
+		}
+	}
+
+	if (headless) {
+		double elapsed = glfwGetTime() - startTime;
+		cout << "Rendered " << frames << " frames in " << elapsed << " s (" << frames / elapsed << " fps)" << endl;
+	}
+
+	if (!capturePath.empty())
+		frameCapture.stop();
+
+	threadPool.stop(); //Lets any loads still running finish before we free what they write to
+	framePacer.destroy();
+
+#ifdef PONG_PROFILE
+	if (!tracePath.empty()) {
+		if (profiler.write(tracePath))
+			cout << "Wrote trace to " << tracePath << endl;
+		else
+			cout << "Error: Failed to write trace to " << tracePath << endl;
+	}
+#else
+	if (!tracePath.empty())
+		cout << "Error: --trace needs a build with PONG_PROFILE defined" << endl;
+#endif
+
+	testTexture.destroy();
+	particles.destroy();
+	leftScoreText.destroy();
+	rightScoreText.destroy();
+	fpsText.destroy();
+	gpuTimesText.destroy();
+	hudText.destroy();
+	uiAtlas.destroy();
+	hudFont.reset();
+	assetManager.clear();
+
+	if (!softwareRendering) {
+		if (headless)
+			offscreenTarget.destroy();
+		postProcess.destroy();
+		if (sceneTarget.fbo)
+			sceneTarget.destroy();
+		gpuProfiler.destroy();
+		quadBatch.destroy();
+		streamBuffer.destroy();
+		shaders.destroy();
 	}
 
 	//Clean up GLFW
@@ -262,150 +526,97 @@ static void keyCallback(GLFWwindow* window, int key, int scancode, int action, i
 	}
 }
 
-//Taken from https://stackoverflow.com/a/2602258
-string readFile(string file) {
-	ifstream t(file); //Create inputstream from file
-	stringstream buffer; //Create stringstream to read file
-	buffer << t.rdbuf(); //Read file into stringstream
-
-	return buffer.str(); //Return string from stringstream
-}
-
-void draw(float* vertices) {
-	//Generate the VAO for our current vertices
-	GLuint vao = genVAO(vertices);
-
-	//Use our shader program
-	glUseProgram(shaderProgram);
-
-	//Bind our VAO
-	glBindVertexArray(vao);
-
-	//Draw the triangle, 0 is the starting index of our array, 3 is the number of vertices
-	glDrawArrays(GL_TRIANGLES, 0, 3);
-}
-
 void updateScreen() {
+	PROFILE_FUNCTION();
 	//Clear previous frame
-	glClear(GL_COLOR_BUFFER_BIT);
-	glUseProgram(shaderProgram);
+	renderQueue.clear(0.0f, 0.0f, 0.0f, 1.0f);
 
 	//Draw paddles
 	leftPaddle.drawSelf();
 	rightPaddle.drawSelf();
 	ball.drawSelf();
+	particles.record(LAYER_BACKGROUND, shaders.get<SHADER_PARTICLE, 0>()); //Under the paddles, so they run straight into the HUD
 
 	//Rect(-1.0f, -1.0f, 4.0f, 2.0f).drawSelf(); //White rectangle covering entire screen
 
-	glfwSwapBuffers(window); //Updates screen, we write to one buffer, while we display the other
-}
-
-//OpenGL flags are of type GLenum
-GLuint loadShader(string file, GLenum type) {
-	//cout << "Loading shader: " << file << ", Type: " << type << endl;
-
-	//Compile shaders, taken from https://learnopengl.com/Getting-started/Hello-Triangle
-	string code = readFile(file);
-	//String to char array from https://www.geeksforgeeks.org/convert-string-char-array-cpp/, make to use length+1 to leave room for terminating character!
-	char* source = new char[code.length() + 1];
-	strcpy_s(source, code.length() + 1, code.c_str());
-
-	//cout << endl << source << endl;
-
-	GLuint shader = glCreateShader(type);
-	glShaderSource(shader, 1, &source, NULL);
-	glCompileShader(shader);
-
-	//Check for errors
-	int success;
-	char infoLog[512];
-	glGetProgramiv(shader, GL_COMPILE_STATUS, &success);
-
-	if (!success) {
-		glGetShaderInfoLog(shader, 512, NULL, infoLog);
-		cout << "Error: Shader compilation failed. Source File: " << file << " Details:\n" << infoLog << endl;
+	//Text is only laid out and uploaded again when what it shows changes, otherwise it's one retained draw for all of it
+	if (leftScoreText.outdated(scoreVersion)) {
+		leftScoreText.set(scoreVersion, to_string(leftScore));
+		rightScoreText.set(scoreVersion, to_string(rightScore));
 	}
-
-	return shader;
-}
-
-int createShaderProgram(GLuint& program, string vertFile, string fragFile) {
-	GLuint vert = loadShader(vertFile, GL_VERTEX_SHADER);
-	GLuint frag = loadShader(fragFile, GL_FRAGMENT_SHADER);
-
-	program = glCreateProgram();
-	glAttachShader(program, vert);
-	glAttachShader(program, frag);
-	glLinkProgram(program);
-
-	//Error checking
-	int success;
-	char infoLog[512];
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-
-	if (!success) {
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		cout << "Error: Shader linking failed. Program: " << program << ", Vert File: " << vertFile << ", Frag File: " << fragFile << " Details:\n" << infoLog << endl;
-		return 7;
+	if (fpsText.outdated(fpsVersion))
+		fpsText.set(fpsVersion, "FPS " + to_string((int)(fps + 0.5f)));
+
+	leftScoreText.draw(hudText);
+	rightScoreText.draw(hudText);
+	fpsText.draw(hudText);
+
+	if (gpuTimes && gpuProfiler.enabled) {
+		if (gpuTimesText.outdated(gpuProfiler.version) && cpuTimeFrames > 0) {
+			ostringstream text;
+			text << gpuProfiler.summary() << "  CPU " << fixed << setprecision(2) << cpuTimeSum / cpuTimeFrames * 1000 << " ms";
+			text << "  GL state " << glState.lastFrame.issued << "/" << glState.lastFrame.issued + glState.lastFrame.elided;
+			if (dynamicResolution.enabled)
+				text << "  scene " << glBackend.sceneWidth << "x" << glBackend.sceneHeight;
+			gpuTimesText.set(gpuProfiler.version, text.str());
+			cpuTimeSum = 0;
+			cpuTimeFrames = 0;
+		}
+		gpuTimesText.draw(hudText);
 	}
+	hudText.draw();
 
-	glDeleteShader(vert);
-	glDeleteShader(frag);
+	//Everything above only recorded commands, this is where they actually get drawn
+	gpuProfiler.begin(GPU_PASS_TEXTURES);
+	uiAtlas.upload();
+	gpuProfiler.end();
+	{
+		PROFILE_SCOPE("renderQueue.submit");
+		renderQueue.submit(*renderBackend);
+	}
 
-	return 0;
+	if (!capturePath.empty()) {
+		if (softwareRendering)
+			frameCapture.captureSoftware((const unsigned char*)softwareRenderer.pixels.data());
+		else
+			frameCapture.captureGL(glBackend.target ? glBackend.target->fbo : 0);
+	}
+	//Everything after this is waiting on vsync or the GPU
+	cpuTimeSum += glfwGetTime() - lastTime;
+	cpuTimeFrames++;
+
+	if (!(softwareRendering && headless)) {
+		PROFILE_SCOPE("present"); //glfwSwapBuffers, or the GDI blit with --software
+		framePacer.beginPresent();
+		renderBackend->present(window);
+		framePacer.endPresent();
+	}
 }
 
-int initShaders() {
-	//Load normal shader
-	if(createShaderProgram(shaderProgram, "src/shaders/vertex.vert", "src/shaders/fragment.frag") != 0)
-		return 7;
+void initShaders() {
+	PROFILE_FUNCTION();
+	shaderCache.init("shaders.cache");
+	shaderBuilder.init();
+	shaders.init();
 
-	//Load text shader
-	if(createShaderProgram(textShader, "src/shaders/text.vert", "src/shaders/text.frag") != 0)
-		return 7;
+	//Every variant drawn with, anything else only gets compiled if something asks for it
+	shaders.require<SHADER_QUAD, SHADER_COLORED | SHADER_TEXTURED | SHADER_SDF>(); //Scores, FPS, and the paddles and ball through the atlas's white patch
+	postProcess.require(postFeatures);
+	shaders.require<SHADER_PARTICLE, 0>(); //Trail and sparks
 
-	return 0;
+	//Get every compile going now, finishShaders() collects them
+	shaderBuilder.update();
 }
 
-GLuint genVAO(float *vertices) {
-	//Create buffer
-	GLuint vbo;
-	glGenBuffers(1, &vbo);
-
-	//Bind the buffer and its data
-	glBindBuffer(GL_ARRAY_BUFFER, vbo); //Set buffer type
-	glBufferData(GL_ARRAY_BUFFER, 9 * sizeof(float), vertices, GL_STATIC_DRAW); //Set the buffer's data
-
-	GLuint vao;
-
-	//Generate VAO
-	glGenVertexArrays(1, &vao);
-
-	glBindVertexArray(vao);
-	glEnableVertexAttribArray(0);
-
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	//Configure how vbo is interpreted, 0 is the first value, since we said position is at location 0 in our vertex shader
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-
-	return vao;
-}
+int finishShaders() {
+	PROFILE_FUNCTION();
+	//The driver compiles while the pool keeps decoding, keep texture uploads moving in the meantime
+	while (!shaderBuilder.update()) {
+		updateTextures();
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
 
-GLuint genTextVAO() {
-	unsigned int vao, vbo;
-
-	//Create and configure VAO and VBO
-	glGenVertexArrays(1, &vao);
-	glGenBuffers(1, &vbo);
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-
-	return vao;
+	return shaderBuilder.failed > 0 ? 7 : 0;
 }
 
 void resetGame() {
@@ -430,11 +641,18 @@ void resetGame() {
 }
 
 void moveBall() {
+	PROFILE_FUNCTION();
 	ball.x += ball.velX * ballSpeed * deltaTime;
 	ball.y += ball.velY * ballSpeed * deltaTime;
 
-	if (abs(ball.y) >= 1 || ball.y + ball.height >= 1)
+	if (abs(ball.y) >= 1 || ball.y + ball.height >= 1) {
 		ball.velY *= -1;
+
+		//Sparks off the wall it hit, the way the ball now goes
+		float wallY = ball.velY > 0 ? ball.y : ball.y + ball.height;
+		particles.emit(IMPACT_SPARKS, ball.x + ball.width / 2, wallY, ball.velY > 0 ? PI / 2 : -PI / 2, PI / 3, 0.5f, 1.5f,
+			0.3f, 0.8f, 0.012f, 1.0f, 0.6f, 0.2f);
+	}
 	
 	bool bounceX = abs(ball.x) >= 1;
 	
@@ -442,22 +660,43 @@ void moveBall() {
 	if (ball.y + ball.height > leftPaddle.y && ball.y < leftPaddle.y + leftPaddle.height && ball.x <= leftPaddle.x + leftPaddle.width) bounceX = true;
 	else if (ball.y + ball.height > rightPaddle.y && ball.y < rightPaddle.y + rightPaddle.height && ball.x + ball.width >= rightPaddle.x) bounceX = true;
 
+	float centerX = ball.x + ball.width / 2, centerY = ball.y + ball.height / 2;
+
 	if (bounceX) {
 		ball.velX *= -1;
 		ballSpeed += BALL_SPEED_INCREASE;
+
+		//Sparks off whatever it hit, back the way the ball's now going
+		particles.emit(IMPACT_SPARKS, centerX, centerY, ball.velX > 0 ? 0.0f : PI, PI / 3, 0.5f, 1.5f, 0.3f, 0.8f, 0.012f, 1.0f, 0.6f, 0.2f);
 	}
 
+	//Trail, drifting a little behind the ball
+	trailRemainder += TRAIL_RATE * deltaTime;
+	int trail = (int)trailRemainder;
+	trailRemainder -= trail;
+	particles.emit(trail, centerX, centerY, (float)atan2(-ball.velY, -ball.velX), PI / 4, 0.02f, 0.1f, 0.2f, 0.4f, 0.02f, 0.6f, 0.8f, 1.0f);
+
 	//Check if ball is out of bounds
 	if (ball.x <= -1) {
 		rightScore++;
+		scoreVersion++;
 		resetGame();
 	}
 	else if (ball.x >= 1) {
 		leftScore++;
+		scoreVersion++;
 		resetGame();
 	}
 }
 
+void emitStressParticles() {
+	//Long lives so only a few percent need replacing a frame
+	for (int missing = stressParticles - particles.count; missing > 0; missing--) {
+		particles.emit(1, particles.random(-1.0f, 1.0f), particles.random(-1.0f, 1.0f), 0.0f, PI, 0.05f, 0.2f, 2.0f, 4.0f,
+			0.004f, particles.random(0.2f, 1.0f), 0.3f, particles.random(0.2f, 1.0f));
+	}
+}
+
 void movePaddle(Rect& paddle, float dir) {
 	float speed = PADDLE_SPEED * deltaTime;
 	
@@ -467,6 +706,7 @@ void movePaddle(Rect& paddle, float dir) {
 }
 
 void handleKeys() {
+	PROFILE_FUNCTION();
 	float left = leftDir, right = rightDir;
 	
 	left *= PADDLE_SPEED * deltaTime;
@@ -474,4 +714,19 @@ void handleKeys() {
 
 	movePaddle(leftPaddle, left);
 	movePaddle(rightPaddle, right);
+}
+
+void updateTextures() {
+	PROFILE_FUNCTION();
+	gpuProfiler.begin(GPU_PASS_TEXTURES);
+	testTexture.update(assetManager);
+	gpuProfiler.end();
+	if (!softwareRendering)
+		return;
+
+	//The software renderer keeps its own copy, hand the pixels over once they're decoded
+	if (testTexture.ready() && testTexture.bytes) {
+		testTexture.textureID = softwareRenderer.addTexture(testTexture.bytes, testTexture.width, testTexture.height, 4);
+		testTexture.freePixels();
+	}
 }
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "ParticleSystem.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <emmintrin.h> //SSE2
+
+ParticleSystem particles;
+
+static const int CHUNK_SIZE = 16384; //Particles per parallelFor job, a multiple of 4
+
+void ParticleSystem::init(int capacity, float aspect, ThreadPool* pool, bool gl) {
+	this->capacity = (capacity + 3) & ~3;
+	this->aspect = aspect;
+	this->pool = pool;
+	this->gl = gl;
+	count = drawCount = 0;
+
+	for (std::vector<float>* array : { &x, &y, &velX, &velY, &size, &life, &invLifetime })
+		array->assign(this->capacity, 0.0f);
+	color.assign(this->capacity, 0);
+
+	if (!gl) {
+		cpuInstances.resize(this->capacity);
+		return;
+	}
+
+	particleStream.init(this->capacity * sizeof(ParticleInstance));
+
+	const float corners[] = {
+		0.0f, 0.0f,
+		1.0f, 0.0f,
+		0.0f, 1.0f,
+		1.0f, 1.0f
+	};
+
+	glGenBuffers(1, &quadVBO);
+	glState.bindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//Same layout idea as QuadBatch, binding 0 is the unit quad and binding 1 the instances. See particle.vert
+	glGenVertexArrays(1, &vao);
+	glState.bindVertexArray(vao);
+	glBindVertexBuffer(0, quadVBO, 0, 2 * sizeof(float));
+	glVertexBindingDivisor(1, 1);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(0, 0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(ParticleInstance, x));
+	glVertexAttribBinding(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribFormat(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(ParticleInstance, color));
+	glVertexAttribBinding(2, 1);
+
+	glState.bindVertexArray(0);
+}
+
+float ParticleSystem::random(float min, float max) {
+	//xorshift32, quality doesn't matter for sparks and rand() is too slow for thousands a frame
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return min + (max - min) * (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::emit(int emitCount, float emitX, float emitY, float angle, float spread, float minSpeed, float maxSpeed,
+	float minLife, float maxLife, float emitSize, float r, float g, float b) {
+	emitCount = std::min(emitCount, capacity - count);
+	uint32_t rgb = (uint32_t)(std::min(std::max(r, 0.0f), 1.0f) * 255.0f + 0.5f) |
+		(uint32_t)(std::min(std::max(g, 0.0f), 1.0f) * 255.0f + 0.5f) << 8 |
+		(uint32_t)(std::min(std::max(b, 0.0f), 1.0f) * 255.0f + 0.5f) << 16;
+
+	for (int i = count; i < count + emitCount; i++) {
+		float direction = angle + random(-spread, spread);
+		float speed = random(minSpeed, maxSpeed);
+		float lifetime = random(minLife, maxLife);
+
+		x[i] = emitX;
+		y[i] = emitY;
+		velX[i] = std::cos(direction) * speed;
+		velY[i] = std::sin(direction) * speed;
+		size[i] = emitSize;
+		life[i] = lifetime;
+		invLifetime[i] = 1.0f / lifetime;
+		color[i] = rgb;
+	}
+
+	count += emitCount;
+}
+
+void ParticleSystem::update(float deltaTime) {
+	//Swap out whatever died last update with the last particle, which gets checked in its new place
+	for (int i = 0; i < count;) {
+		if (life[i] > 0.0f) {
+			i++;
+			continue;
+		}
+
+		count--;
+		x[i] = x[count];
+		y[i] = y[count];
+		velX[i] = velX[count];
+		velY[i] = velY[count];
+		size[i] = size[count];
+		life[i] = life[count];
+		invLifetime[i] = invLifetime[count];
+		color[i] = color[count];
+	}
+
+	//Previous region was drawn, move on. If it wasn't, the GPU isn't reading it and we can just write it again
+	if (gl && drawn) {
+		particleStream.beginFrame();
+		instances = (ParticleInstance*)particleStream.alloc(capacity * sizeof(ParticleInstance), instanceOffset);
+		drawn = false;
+	}
+	else if (!gl)
+		instances = cpuInstances.data();
+
+	drawCount = instances ? count : 0;
+	if (drawCount == 0)
+		return;
+
+	const __m128 dt = _mm_set1_ps(deltaTime);
+	const __m128 damping = _mm_set1_ps(std::exp(-drag * deltaTime));
+	const __m128 fall = _mm_set1_ps(gravity * deltaTime);
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), alphaScale = _mm_set1_ps(255.0f);
+
+	//Groups of 4 run past count into the padding, which is harmless, it's never drawn
+	int chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	auto step = [&](int chunk) {
+		int end = std::min(count, (chunk + 1) * CHUNK_SIZE);
+		for (int i = chunk * CHUNK_SIZE; i < end; i += 4) {
+			__m128 vx = _mm_mul_ps(_mm_loadu_ps(&velX[i]), damping);
+			__m128 vy = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&velY[i]), damping), fall);
+			__m128 px = _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(vx, dt));
+			__m128 py = _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(vy, dt));
+			__m128 remaining = _mm_sub_ps(_mm_loadu_ps(&life[i]), dt);
+
+			_mm_storeu_ps(&velX[i], vx);
+			_mm_storeu_ps(&velY[i], vy);
+			_mm_storeu_ps(&x[i], px);
+			_mm_storeu_ps(&y[i], py);
+			_mm_storeu_ps(&life[i], remaining);
+
+			//Fade out over the lifetime, alpha into the top byte of the color
+			__m128 alpha = _mm_min_ps(one, _mm_max_ps(zero, _mm_mul_ps(remaining, _mm_loadu_ps(&invLifetime[i]))));
+			__m128i rgba = _mm_or_si128(_mm_loadu_si128((const __m128i*)&color[i]), _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(alpha, alphaScale)), 24));
+
+			//Four particles' x, y, size, color as columns, transposed into four instances
+			__m128 c0 = px, c1 = py, c2 = _mm_loadu_ps(&size[i]), c3 = _mm_castsi128_ps(rgba);
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			_mm_storeu_ps((float*)&instances[i], c0);
+			_mm_storeu_ps((float*)&instances[i + 1], c1);
+			_mm_storeu_ps((float*)&instances[i + 2], c2);
+			_mm_storeu_ps((float*)&instances[i + 3], c3);
+		}
+	};
+
+	if (pool && chunks > 1)
+		pool->parallelFor(chunks, step);
+	else {
+		for (int chunk = 0; chunk < chunks; chunk++)
+			step(chunk);
+	}
+}
+
+void ParticleSystem::record(int layer, GLuint program) {
+	if (drawCount == 0)
+		return;
+
+	RenderCommand command;
+	command.type = COMMAND_PARTICLES;
+	command.layer = layer;
+	command.blend = BLEND_ADDITIVE;
+	command.program = program;
+	command.particles = this;
+	renderQueue.push(command);
+}
+
+void ParticleSystem::draw() {
+	if (drawn || drawCount == 0)
+		return;
+
+	glUniform1f(0, aspect);
+
+	glState.bindVertexArray(vao);
+	glBindVertexBuffer(1, particleStream.buffer, instanceOffset, sizeof(ParticleInstance));
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, drawCount);
+
+	particleStream.endFrame();
+	drawn = true;
+}
+
+void ParticleSystem::destroy() {
+	if (gl) {
+		particleStream.destroy();
+		glState.deleteBuffer(quadVBO);
+		glState.deleteVertexArray(vao);
+		vao = quadVBO = 0;
+	}
+
+	for (std::vector<float>* array : { &x, &y, &velX, &velY, &size, &life, &invLifetime })
+		std::vector<float>().swap(*array);
+	std::vector<uint32_t>().swap(color);
+	std::vector<ParticleInstance>().swap(cpuInstances);
+	instances = nullptr;
+	capacity = count = drawCount = 0;
+}
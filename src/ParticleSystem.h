@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "StreamBuffer.h"
+#include "ThreadPool.h"
+
+//What the GPU gets per particle, 16 bytes
+struct ParticleInstance {
+	float x, y; //Center, NDC
+	float size; //Height in NDC, the width is scaled by aspect so particles stay square
+	uint32_t color; //RGBA8, alpha already faded by age
+};
+
+//Everything in the ball's trail and the sparks off the paddles. Particles are kept as structure of arrays, so update()
+//can step four at a time with SSE2 across the thread pool, and it writes the instance data in the same pass straight
+//into a persistently mapped buffer that's drawn with one instanced call. Storage is allocated once in init(), emitting
+//only writes into it and a full system drops new particles, so nothing is allocated per particle.
+//Dead particles are drawn transparent for the frame they die in and swapped out at the start of the next update().
+struct ParticleSystem {
+	int capacity = 0; //Multiple of 4
+	int count = 0; //Live, plus any that died last update
+	int drawCount = 0; //Instances written by the last update()
+
+	//Structure of arrays, capacity long
+	std::vector<float> x, y, velX, velY, size, life, invLifetime; //life counts down in seconds, invLifetime is 1 / its start
+	std::vector<uint32_t> color; //RGBA8 with alpha 0, it comes from life
+
+	float drag = 2.0f; //Velocity lost per second, as a rate
+	float gravity = 0.0f; //NDC per second squared, down
+	float aspect = 1.0f; //Screen height / width
+
+	ThreadPool* pool = nullptr;
+	uint32_t seed = 0x9E3779B9;
+
+	//GL only, instances go through particleStream. Without GL they're written to cpuInstances instead
+	bool gl = false;
+	StreamBuffer particleStream;
+	GLuint vao = 0, quadVBO = 0;
+	GLintptr instanceOffset = 0;
+	bool drawn = true; //The current region's been drawn, so update() has to move to the next
+	std::vector<ParticleInstance> cpuInstances;
+	ParticleInstance* instances = nullptr; //This frame's, from update()
+
+	void init(int capacity, float aspect, ThreadPool* pool, bool gl);
+
+	//Random in [min, max)
+	float random(float min, float max);
+
+	//count particles at (x, y) heading in directions within spread radians of angle, at speeds between minSpeed and
+	//maxSpeed. Lifetimes are between minLife and maxLife seconds
+	void emit(int count, float x, float y, float angle, float spread, float minSpeed, float maxSpeed,
+		float minLife, float maxLife, float size, float r, float g, float b);
+
+	//Moves and ages everything by deltaTime and writes this frame's instances
+	void update(float deltaTime);
+
+	//Records the instances with renderQueue, additive, on layer
+	void record(int layer, GLuint program);
+
+	//GL backend only, draws the instances with the bound program and fences them
+	void draw();
+
+	void destroy();
+};
+
+extern ParticleSystem particles;
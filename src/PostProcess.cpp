@@ -0,0 +1,89 @@
+#include "PostProcess.h"
+#include "GLState.h"
+#include "GpuProfiler.h"
+#include "ShaderPermutations.h"
+
+#include <algorithm>
+
+PostProcess postProcess;
+
+void PostProcess::require(uint32_t features) {
+	if (features & SHADER_BLOOM) {
+		shaders.require<SHADER_BLOOM_DOWNSAMPLE, SHADER_BRIGHT_PASS>();
+		shaders.require<SHADER_BLOOM_DOWNSAMPLE, 0>();
+	}
+	if (features)
+		shaders.require(SHADER_POST, features);
+}
+
+bool PostProcess::init(int width, int height, uint32_t features) {
+	this->features = features;
+	if (!features)
+		return true;
+
+	if (features & SHADER_BLOOM) {
+		for (int i = 0; i < BLOOM_LEVELS; i++) {
+			if (!bloom[i].init(std::max(1, width >> (i + 1)), std::max(1, height >> (i + 1))))
+				return false;
+		}
+	}
+
+	glGenVertexArrays(1, &vao);
+	return true;
+}
+
+//Full screen triangle over whatever's bound
+static void drawTriangle() {
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void PostProcess::apply(const Framebuffer& scene, int sceneWidth, int sceneHeight, GLuint targetFBO, int targetWidth, int targetHeight) {
+	float scaleX = (float)sceneWidth / scene.width, scaleY = (float)sceneHeight / scene.height;
+
+	glState.setBlend(false);
+	glState.bindVertexArray(vao);
+
+	if (features & SHADER_BLOOM) {
+		gpuProfiler.begin(GPU_PASS_BLOOM);
+
+		for (int i = 0; i < BLOOM_LEVELS; i++) {
+			//The first level reads the used part of the scene and thresholds it, the rest halve the level before
+			const Framebuffer& source = i == 0 ? scene : bloom[i - 1];
+			glState.useProgram(i == 0 ? shaders.get<SHADER_BLOOM_DOWNSAMPLE, SHADER_BRIGHT_PASS>() : shaders.get<SHADER_BLOOM_DOWNSAMPLE, 0>());
+			glState.bindFramebuffer(bloom[i].fbo);
+			glViewport(0, 0, bloom[i].width, bloom[i].height);
+			glState.bindTexture(0, source.colorTexture);
+
+			glUniform2f(0, 1.0f / source.width, 1.0f / source.height);
+			glUniform2f(1, i == 0 ? scaleX : 1.0f, i == 0 ? scaleY : 1.0f);
+			drawTriangle();
+		}
+	}
+
+	gpuProfiler.begin(GPU_PASS_POST);
+
+	glState.bindFramebuffer(targetFBO);
+	glViewport(0, 0, targetWidth, targetHeight);
+	glState.useProgram(shaders.get(SHADER_POST, features));
+	glState.bindTexture(0, scene.colorTexture);
+	if (features & SHADER_BLOOM) {
+		for (int i = 0; i < BLOOM_LEVELS; i++)
+			glState.bindTexture(1 + i, bloom[i].colorTexture);
+	}
+
+	glUniform2f(0, scaleX, scaleY);
+	glUniform2f(1, 1.0f / scene.width, 1.0f / scene.height);
+	glUniform2f(2, (float)targetWidth, (float)targetHeight);
+	drawTriangle();
+}
+
+void PostProcess::destroy() {
+	if (features & SHADER_BLOOM) {
+		for (Framebuffer& level : bloom)
+			level.destroy();
+	}
+	if (vao)
+		glState.deleteVertexArray(vao);
+	vao = 0;
+	features = 0;
+}
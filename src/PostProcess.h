@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "Framebuffer.h"
+
+//Arcade style effects over the playfield, all done in one full screen pass (post.frag) no matter how many are on.
+//CRT curvature, vignette and scanlines are just math on the coordinates. Bloom needs blurred highlights, which come
+//from a chain of downsamples starting at half resolution, each level a quarter of the pixels of the last, so the whole
+//chain costs about a third of one half resolution pass. The fused pass also does dynamic resolution's upscale.
+//The HUD is drawn after this, so it stays flat and sharp.
+struct PostProcess {
+	static const int BLOOM_LEVELS = 4; //post.frag has the same
+
+	uint32_t features = 0; //Any of SHADER_CRT, SHADER_BLOOM and SHADER_SCANLINES, 0 is off
+	Framebuffer bloom[BLOOM_LEVELS];
+	GLuint vao = 0; //Empty, post.vert makes its triangle from gl_VertexID
+
+	bool active() const { return features != 0; }
+
+	//Queues the programs features needs, call while the other shaders are being required
+	void require(uint32_t features);
+
+	//Needs the GL context. width and height are the scene's full size
+	bool init(int width, int height, uint32_t features);
+
+	//Draws the used sceneWidth x sceneHeight of scene over the whole target with every effect, leaving the target bound.
+	//Blend, program, texture and VAO state are all changed
+	void apply(const Framebuffer& scene, int sceneWidth, int sceneHeight, GLuint targetFBO, int targetWidth, int targetHeight);
+
+	void destroy();
+};
+
+extern PostProcess postProcess;
@@ -0,0 +1,101 @@
+#include "Profiler.h"
+
+#ifdef PONG_PROFILE
+
+#include <chrono>
+#include <fstream>
+
+Profiler profiler;
+
+thread_local ProfileBuffer* profileThreadBuffer = nullptr;
+
+static int64_t clockNanoseconds() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ProfileBuffer::newChunk() {
+	std::lock_guard<std::mutex> lock(mutex);
+	chunks.emplace_back(new ProfileChunk); //Not value initialized, events are written before they're read
+	current = chunks.back().get();
+	used = 0;
+}
+
+Profiler::Profiler() {
+	startTicks = ticks();
+	startNanoseconds = clockNanoseconds();
+}
+
+ProfileBuffer& Profiler::newBuffer() {
+	ProfileBuffer* buffer = new ProfileBuffer();
+	buffer->newChunk();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		buffer->threadId = (int)buffers.size() + 1;
+		buffers.emplace_back(buffer);
+	}
+
+	profileThreadBuffer = buffer;
+	return *buffer;
+}
+
+void Profiler::nameThread(const std::string& name) {
+	ProfileBuffer& own = buffer();
+	std::lock_guard<std::mutex> lock(own.mutex);
+	own.threadName = name;
+}
+
+//Names come from our own literals, but keep the JSON valid whatever they are
+static void writeString(std::ofstream& out, const char* text) {
+	out << '"';
+	for (const char* c = text; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			out << '\\' << *c;
+		else if ((unsigned char)*c >= 0x20)
+			out << *c;
+	}
+	out << '"';
+}
+
+bool Profiler::write(const std::string& path) {
+	//Trace timestamps are microseconds, fractions are fine
+	double microsecondsPerTick = (clockNanoseconds() - startNanoseconds) / 1000.0 / (double)(ticks() - startTicks);
+
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	out.precision(3);
+	out << std::fixed;
+
+	bool first = true;
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const std::unique_ptr<ProfileBuffer>& buffer : buffers) {
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+		if (!buffer->threadName.empty()) {
+			out << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+			writeString(out, buffer->threadName.c_str());
+			out << "}}";
+			first = false;
+		}
+
+		for (const std::unique_ptr<ProfileChunk>& chunk : buffer->chunks) {
+			int count = chunk->count.load(std::memory_order_acquire);
+			for (int i = 0; i < count; i++) {
+				const ProfileEvent& event = chunk->events[i];
+				out << (first ? "" : ",") << "\n{\"ph\":\"X\",\"name\":";
+				writeString(out, event.name);
+				out << ",\"pid\":1,\"tid\":" << buffer->threadId
+					<< ",\"ts\":" << (event.start - startTicks) * microsecondsPerTick
+					<< ",\"dur\":" << (event.end - event.start) * microsecondsPerTick << "}";
+				first = false;
+			}
+		}
+	}
+
+	out << "\n]}\n";
+	return (bool)out;
+}
+
+#endif
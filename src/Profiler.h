@@ -0,0 +1,116 @@
+#pragma once
+
+//CPU instrumentation written out in Chrome's trace event format, open the file in chrome://tracing or ui.perfetto.dev.
+//Only built with PONG_PROFILE defined, otherwise every macro below expands to nothing and none of this exists.
+//
+//PROFILE_SCOPE("name") times from there to the end of the enclosing block. Names have to be string literals or otherwise
+//outlive the profiler, only the pointer is kept. Each thread records into its own buffer, so a scope is two rdtsc reads
+//and one store with no locks. Ticks are turned into nanoseconds when the trace is written, by timing the TSC against
+//steady_clock over the whole run.
+#ifdef PONG_PROFILE
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+struct ProfileEvent {
+	const char* name;
+	uint64_t start, end; //TSC ticks
+};
+
+//Events are never moved once written, full chunks are kept and a new one started
+struct ProfileChunk {
+	static const int SIZE = 4096;
+	ProfileEvent events[SIZE];
+	std::atomic<int> count{ 0 }; //Events the writer has finished, the reader never looks past this
+};
+
+//One per thread that's recorded anything, owned by the profiler so it outlives the thread
+struct ProfileBuffer {
+	std::mutex mutex; //Only for adding chunks and the name, never taken per event
+	std::vector<std::unique_ptr<ProfileChunk>> chunks;
+	ProfileChunk* current = nullptr;
+	int used = 0; //Events in current, only touched by the owning thread
+	int threadId = 0;
+	std::string threadName;
+
+	void newChunk();
+
+	void push(const char* name, uint64_t start, uint64_t end) {
+		if (used == ProfileChunk::SIZE)
+			newChunk();
+
+		current->events[used] = { name, start, end };
+		current->count.store(++used, std::memory_order_release);
+	}
+};
+
+struct Profiler {
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ProfileBuffer>> buffers;
+
+	//Ticks and clock read together at startup, write() compares them to now to get the tick rate
+	uint64_t startTicks;
+	int64_t startNanoseconds;
+
+	Profiler();
+
+	static uint64_t ticks() { return __rdtsc(); }
+
+	//This thread's buffer, made on first use
+	ProfileBuffer& buffer();
+	ProfileBuffer& newBuffer();
+
+	//Shown as the thread's name in the trace
+	void nameThread(const std::string& name);
+
+	void record(const char* name, uint64_t start, uint64_t end);
+
+	//Writes everything recorded so far as a trace event JSON file. Events still being written on other threads are
+	//left out rather than waited for. False if the file couldn't be written
+	bool write(const std::string& path);
+};
+
+extern Profiler profiler;
+
+//Cached so record() doesn't go through the profiler's mutex, the buffer itself belongs to the profiler
+extern thread_local ProfileBuffer* profileThreadBuffer;
+
+inline ProfileBuffer& Profiler::buffer() {
+	return profileThreadBuffer ? *profileThreadBuffer : newBuffer();
+}
+
+inline void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+	buffer().push(name, start, end);
+}
+
+struct ProfileScope {
+	const char* name;
+	uint64_t start;
+
+	explicit ProfileScope(const char* name) : name(name), start(Profiler::ticks()) {}
+	~ProfileScope() { profiler.record(name, start, Profiler::ticks()); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD(name) profiler.nameThread(name)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD(name)
+
+#endif
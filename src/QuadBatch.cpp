@@ -0,0 +1,116 @@
+#include "QuadBatch.h"
+#include "GLState.h"
+
+#include <cstddef>
+
+void QuadBatch::init(int maxQuads, StreamBuffer* stream) {
+	this->maxQuads = maxQuads;
+	this->stream = stream;
+	instances.reserve(maxQuads);
+
+	//Corners of the unit quad, drawn as a triangle strip
+	const float corners[] = {
+		0.0f, 0.0f,
+		1.0f, 0.0f,
+		0.0f, 1.0f,
+		1.0f, 1.0f
+	};
+
+	//Unit quad, never changes
+	glGenBuffers(1, &quadVBO);
+	glState.bindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenVertexArrays(1, &vao);
+	glState.bindVertexArray(vao);
+
+	//Binding 0 is the unit quad, binding 1 is the instances. Instances live at a different offset in the stream buffer
+	//every flush, so we use separate bindings and only rebind the buffer range instead of respecifying every attribute
+	glBindVertexBuffer(0, quadVBO, 0, 2 * sizeof(float));
+	glVertexBindingDivisor(1, 1); //Advance once per instance instead of per vertex
+
+	//Location 0 is the corner, location 1 is the rect, location 2 is the color, location 3 is the texture coords, see vertex.vert
+	glEnableVertexAttribArray(0);
+	glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(0, 0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribFormat(1, 4, GL_FLOAT, GL_FALSE, offsetof(Instance, x));
+	glVertexAttribBinding(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribFormat(2, 4, GL_FLOAT, GL_FALSE, offsetof(Instance, r));
+	glVertexAttribBinding(2, 1);
+	glEnableVertexAttribArray(3);
+	glVertexAttribFormat(3, 4, GL_FLOAT, GL_FALSE, offsetof(Instance, u0));
+	glVertexAttribBinding(3, 1);
+
+	glState.bindVertexArray(0);
+}
+
+void QuadBatch::add(float x, float y, float width, float height, float r, float g, float b, float a, float u0, float v0, float u1, float v1) {
+	if ((int)instances.size() >= maxQuads)
+		flush(); //Out of room, draw what we have and start over
+
+	instances.push_back({ x, y, width, height, r, g, b, a, u0, v0, u1, v1 });
+}
+
+void QuadBatch::flush() {
+	if (instances.empty())
+		return;
+
+	GLintptr offset = stream->push(instances.data(), instances.size() * sizeof(Instance));
+	if (offset < 0) {
+		instances.clear(); //No room left this frame, drop the quads rather than overwrite what the GPU is reading
+		return;
+	}
+
+	glState.bindVertexArray(vao);
+	glBindVertexBuffer(1, stream->buffer, offset, sizeof(Instance));
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instances.size());
+
+	instances.clear();
+}
+
+void QuadBatch::draw(QuadList& list) {
+	if (list.instances.empty())
+		return;
+
+	if (!instances.empty()) {
+		//Copying a few dozen instances into the stream is cheaper than breaking the batch for a second draw
+		for (const Instance& instance : list.instances) {
+			if ((int)instances.size() >= maxQuads)
+				flush();
+			instances.push_back(instance);
+		}
+		return;
+	}
+
+	if (!list.buffer || list.uploadedVersion != list.version) {
+		if (!list.buffer)
+			glGenBuffers(1, &list.buffer);
+
+		//Respecifying the whole store orphans the old one, so a frame still drawing from it isn't stalled
+		glState.bindBuffer(GL_ARRAY_BUFFER, list.buffer);
+		glBufferData(GL_ARRAY_BUFFER, list.instances.size() * sizeof(Instance), list.instances.data(), GL_STATIC_DRAW);
+		list.uploadedVersion = list.version;
+	}
+
+	glState.bindVertexArray(vao);
+	glBindVertexBuffer(1, list.buffer, 0, sizeof(Instance));
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)list.instances.size());
+}
+
+void QuadBatch::destroy() {
+	glState.deleteBuffer(quadVBO);
+	glState.deleteVertexArray(vao);
+	vao = quadVBO = 0;
+}
+
+void QuadList::destroy() {
+	if (buffer)
+		glState.deleteBuffer(buffer);
+	buffer = 0;
+	instances.clear();
+}
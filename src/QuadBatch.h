@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "StreamBuffer.h"
+
+struct QuadList;
+
+//Collects every quad drawn during a frame and submits them all in one instanced draw call.
+//One static unit quad is stretched per instance in vertex.vert, so each quad only costs one Instance on the CPU.
+//The VAO and unit quad are created once in init(), instance data is written into the shared StreamBuffer.
+struct QuadBatch {
+	struct Instance {
+		float x, y, width, height; //(x, y) is the bottom left corner
+		float r, g, b, a; //Color
+		float u0, v0, u1, v1; //Texture coords of the bottom left and top right corners
+	};
+
+	GLuint vao = 0, quadVBO = 0;
+	StreamBuffer* stream = nullptr; //Where instance data gets uploaded
+	int maxQuads = 0;
+	std::vector<Instance> instances; //CPU side copy of this frame's quads, reused between frames
+
+	//maxQuads is how many quads fit in one draw call, more than that just means more draw calls
+	void init(int maxQuads, StreamBuffer* stream);
+
+	//Queues a quad, (x, y) is the bottom left corner
+	void add(float x, float y, float width, float height, float r = 1.0f, float g = 1.0f, float b = 1.0f, float a = 1.0f,
+		float u0 = 0.0f, float v0 = 0.0f, float u1 = 1.0f, float v1 = 1.0f);
+
+	//Uploads and draws everything queued since the last flush with the currently bound shader program
+	void flush();
+
+	//Draws a retained list with the currently bound shader program, uploading it first if it changed since last time.
+	//If quads are already queued they must share the list's state, and the list is appended to them instead, so a
+	//run like the playfield followed by the HUD stays one draw
+	void draw(QuadList& list);
+
+	void destroy();
+};
+
+//Quads kept between frames in their own static buffer, for things that rarely change like text layouts.
+//The owner fills instances and bumps version, the GL backend re-uploads on the next draw when the version moved on.
+//Drawing an unchanged list on its own is one command and one draw call, nothing is copied
+struct QuadList {
+	std::vector<QuadBatch::Instance> instances;
+	uint32_t version = 0;
+
+	GLuint buffer = 0; //Created on first draw, stays 0 with the software renderer
+	uint32_t uploadedVersion = 0;
+
+	void destroy();
+};
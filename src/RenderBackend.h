@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+
+#include "RenderQueue.h"
+
+//Something that can turn a frame of sorted RenderCommands into pixels. RenderQueue::submit() hands every frame to one of these.
+struct RenderBackend {
+	virtual ~RenderBackend() {}
+
+	//Draw commands[order[0].index], commands[order[1].index], ... in that order
+	virtual void render(const std::vector<RenderCommand>& commands, const std::vector<RenderQueue::SortEntry>& order) = 0;
+
+	//Put the finished frame on screen
+	virtual void present(GLFWwindow* window) = 0;
+
+	//Blank RGBA texture for content that changes at runtime, the id goes in RenderCommand::texture
+	virtual GLuint createTexture(int width, int height) = 0;
+
+	//Replaces a width x height area at (x, y), pixels is RGBA with stride pixels per row, row 0 is v = 0
+	virtual void updateTexture(GLuint texture, int x, int y, int width, int height, const uint32_t* pixels, int stride) = 0;
+
+	virtual void destroyTexture(GLuint texture) = 0;
+};
@@ -0,0 +1,110 @@
+#include "RenderQueue.h"
+#include "RenderBackend.h"
+
+RenderQueue renderQueue;
+
+uint64_t RenderQueue::makeKey(int layer, BlendMode blend, GLuint program, GLuint texture, uint32_t sequence) {
+	return ((uint64_t)(layer & 0xFF) << 56) |
+		((uint64_t)(blend & 0xF) << 52) |
+		((uint64_t)(program & 0xFFF) << 40) |
+		((uint64_t)(texture & 0xFFFF) << 24) |
+		(uint64_t)(sequence & 0xFFFFFF);
+}
+
+void RenderQueue::push(RenderCommand command) {
+	std::lock_guard<std::mutex> lock(recordMutex);
+
+	command.key = makeKey(command.layer, command.blend, command.program, command.texture, sequence++);
+	recording.push_back(command);
+}
+
+void RenderQueue::clear(float r, float g, float b, float a) {
+	RenderCommand command;
+	command.type = COMMAND_CLEAR;
+	command.layer = LAYER_CLEAR;
+	command.r = r;
+	command.g = g;
+	command.b = b;
+	command.a = a;
+	push(command);
+}
+
+void RenderQueue::drawQuadList(int layer, GLuint program, GLuint texture, QuadList* list) {
+	RenderCommand command;
+	command.type = COMMAND_QUAD_LIST;
+	command.layer = layer;
+	command.program = program;
+	command.texture = texture;
+	command.list = list;
+	push(command);
+}
+
+void RenderQueue::drawTexturedQuad(int layer, GLuint program, GLuint texture, float x, float y, float width, float height,
+	float u0, float v0, float u1, float v1, float r, float g, float b, float a) {
+	RenderCommand command;
+	command.layer = layer;
+	command.program = program;
+	command.texture = texture;
+	command.x = x;
+	command.y = y;
+	command.width = width;
+	command.height = height;
+	command.u0 = u0;
+	command.v0 = v0;
+	command.u1 = u1;
+	command.v1 = v1;
+	command.r = r;
+	command.g = g;
+	command.b = b;
+	command.a = a;
+	push(command);
+}
+
+//LSD radix sort, one byte per pass. Stable, so equal keys keep their order.
+//Passes where every key has the same byte are skipped, which is most of them since few states are in use at once.
+static void radixSort(std::vector<RenderQueue::SortEntry>& entries, std::vector<RenderQueue::SortEntry>& scratch) {
+	scratch.resize(entries.size());
+
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = {};
+		for (const RenderQueue::SortEntry& entry : entries)
+			counts[(entry.key >> shift) & 0xFF]++;
+
+		if (counts[(entries[0].key >> shift) & 0xFF] == entries.size())
+			continue; //Every key has the same byte here
+
+		//Turn counts into starting offsets
+		size_t offset = 0;
+		for (int i = 0; i < 256; i++) {
+			size_t count = counts[i];
+			counts[i] = offset;
+			offset += count;
+		}
+
+		for (const RenderQueue::SortEntry& entry : entries)
+			scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+
+		entries.swap(scratch);
+	}
+}
+
+void RenderQueue::submit(RenderBackend& backend) {
+	//Take the recorded commands, recording can carry on into the other vector while we draw
+	{
+		std::lock_guard<std::mutex> lock(recordMutex);
+		submitting.swap(recording);
+		recording.clear();
+		sequence = 0;
+	}
+
+	if (submitting.empty())
+		return;
+
+	sorted.resize(submitting.size());
+	for (uint32_t i = 0; i < submitting.size(); i++)
+		sorted[i] = { submitting[i].key, i };
+
+	radixSort(sorted, scratch);
+
+	backend.render(submitting, sorted);
+}
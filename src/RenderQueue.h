@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <glad/glad.h>
+
+struct RenderBackend;
+struct QuadList;
+struct ParticleSystem;
+
+//Layers are drawn back to front, they're the most significant part of the sort key
+enum RenderLayer {
+	LAYER_CLEAR = 0, //Reserved for the clear command
+	LAYER_BACKGROUND,
+	LAYER_PLAYFIELD,
+	LAYER_UI
+};
+
+enum BlendMode {
+	BLEND_OPAQUE = 0,
+	BLEND_ALPHA,
+	BLEND_ADDITIVE
+};
+
+enum RenderCommandType {
+	COMMAND_CLEAR,
+	COMMAND_QUAD,
+	COMMAND_QUAD_LIST, //Every quad in list, drawn with the command's state
+	COMMAND_PARTICLES //Every particle written by particles' last update
+};
+
+struct RenderCommand {
+	uint64_t key = 0; //Filled in by RenderQueue::push()
+	RenderCommandType type = COMMAND_QUAD;
+
+	int layer = LAYER_PLAYFIELD;
+	BlendMode blend = BLEND_ALPHA;
+	GLuint program = 0;
+	GLuint texture = 0; //0 for untextured
+
+	//Quad, (x, y) is the bottom left corner in NDC
+	float x = 0, y = 0, width = 0, height = 0;
+	float r = 1, g = 1, b = 1, a = 1; //Also the clear color
+	float u0 = 0, v0 = 0, u1 = 1, v1 = 1; //Texture coords
+
+	QuadList* list = nullptr; //COMMAND_QUAD_LIST only, has to live until the frame is submitted
+	ParticleSystem* particles = nullptr; //COMMAND_PARTICLES only
+};
+
+//Drawables record commands here instead of calling GL. Recording is thread safe, the GL thread then calls submit(),
+//which takes everything recorded so far, sorts it by key so commands sharing state end up next to each other,
+//and hands it to a RenderBackend to draw.
+struct RenderQueue {
+	//Sort key layout, most significant first:
+	//layer (8) | blend (4) | program (12) | texture (16) | sequence (24)
+	//sequence keeps commands with identical state in the order they were recorded
+	static uint64_t makeKey(int layer, BlendMode blend, GLuint program, GLuint texture, uint32_t sequence);
+
+	std::mutex recordMutex;
+	std::vector<RenderCommand> recording; //Filled by push()
+	std::vector<RenderCommand> submitting; //Owned by the GL thread during submit()
+	uint32_t sequence = 0;
+
+	struct SortEntry {
+		uint64_t key;
+		uint32_t index;
+	};
+	std::vector<SortEntry> sorted, scratch; //Kept around so we don't allocate every frame
+
+	void push(RenderCommand command);
+
+	//Helpers for the common commands
+	void clear(float r, float g, float b, float a);
+	void drawTexturedQuad(int layer, GLuint program, GLuint texture, float x, float y, float width, float height,
+		float u0, float v0, float u1, float v1, float r = 1.0f, float g = 1.0f, float b = 1.0f, float a = 1.0f);
+	void drawQuadList(int layer, GLuint program, GLuint texture, QuadList* list);
+
+	//Render thread only, sorts everything recorded since the last submit and draws it with backend
+	void submit(RenderBackend& backend);
+};
+
+extern RenderQueue renderQueue;
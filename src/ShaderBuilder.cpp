@@ -0,0 +1,229 @@
+#include "ShaderBuilder.h"
+#include "ShaderCache.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <GLFW/glfw3.h>
+
+ShaderBuilder shaderBuilder;
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+void ShaderBuilder::init() {
+	startTime = std::chrono::steady_clock::now();
+
+	//Same function under either name, 0xFFFFFFFF lets the driver pick the thread count
+	PFNGLMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreads = nullptr;
+	if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+		maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+	else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+		maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+
+	parallel = maxShaderCompilerThreads != nullptr;
+	if (parallel)
+		maxShaderCompilerThreads(0xFFFFFFFF);
+}
+
+void ShaderBuilder::add(GLuint& program, const std::string& vertFile, const std::string& fragFile, const std::string& defines) {
+	ShaderBuild build;
+	build.target = &program;
+	build.vertFile = vertFile;
+	build.fragFile = fragFile;
+	build.defines = defines;
+
+	//Normally already read ahead by main()
+	build.vertSource = assetManager.loadFile(vertFile);
+	build.fragSource = assetManager.loadFile(fragFile);
+
+	builds.push_back(build);
+	finished = false;
+}
+
+//Length of the source up to and including the #version line, which may have comments before it. 0 if there isn't one
+static GLint versionLineEnd(const char* source, size_t size) {
+	static const char VERSION[] = "#version";
+	const size_t length = sizeof(VERSION) - 1;
+
+	for (size_t i = 0; i + length <= size; i++) {
+		if ((i == 0 || source[i - 1] == '\n') && memcmp(source + i, VERSION, length) == 0) {
+			const char* newline = (const char*)memchr(source + i, '\n', size - i);
+			return newline ? (GLint)(newline - source + 1) : (GLint)size;
+		}
+	}
+
+	return 0;
+}
+
+//Submits a compile and returns straight away, status is checked later by compiled()
+static GLuint compile(const FileAsset& asset, GLenum type, const std::string& defines) {
+	//Straight from the asset, GL takes lengths so there's no need for a terminated copy.
+	//Defines have to come after #version, so the source goes in as three pieces with them in the middle
+	const char* source = (const char*)asset.data;
+	GLint versionLength = versionLineEnd(source, asset.size);
+
+	const char* pieces[3] = { source, defines.c_str(), source + versionLength };
+	GLint lengths[3] = { versionLength, (GLint)defines.size(), (GLint)asset.size - versionLength };
+
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 3, pieces, lengths);
+	glCompileShader(shader);
+	return shader;
+}
+
+//Never blocks with the extension. Without it there's nothing to poll, and the status query is what waits
+static bool shaderReady(GLuint shader, bool parallel) {
+	if (!parallel)
+		return true;
+
+	GLint complete = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+static bool programReady(GLuint program, bool parallel) {
+	if (!parallel)
+		return true;
+
+	GLint complete = GL_FALSE;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+static bool compiled(GLuint shader, const std::string& file) {
+	GLint success;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (success)
+		return true;
+
+	GLint length = 0;
+	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+	std::string infoLog(length > 0 ? length : 1, '\0');
+	glGetShaderInfoLog(shader, (GLsizei)infoLog.size(), NULL, &infoLog[0]);
+	std::cout << "Error: Shader compilation failed. Source File: " << file << " Details:\n" << infoLog.c_str() << std::endl;
+	return false;
+}
+
+static void fail(ShaderBuild& build) {
+	if (build.vert)
+		glDeleteShader(build.vert);
+	if (build.frag)
+		glDeleteShader(build.frag);
+	if (build.program)
+		glDeleteProgram(build.program);
+
+	build.vert = build.frag = build.program = 0;
+	build.state = SHADER_FAILED;
+}
+
+bool ShaderBuilder::update() {
+	bool done = true;
+
+	for (ShaderBuild& build : builds) {
+		switch (build.state) {
+		case SHADER_WAITING: {
+			if (!build.vertSource->finished() || !build.fragSource->finished())
+				break;
+
+			if (build.vertSource->failed() || build.fragSource->failed()) {
+				failed++;
+				fail(build);
+				break;
+			}
+
+			build.key = shaderCache.begin();
+			build.key = ShaderCache::hash(build.key, build.vertSource->data, build.vertSource->size);
+			build.key = ShaderCache::hash(build.key, build.fragSource->data, build.fragSource->size);
+			build.key = ShaderCache::hash(build.key, build.defines.data(), build.defines.size());
+
+			build.program = glCreateProgram();
+			if (shaderCache.load(build.key, build.program)) {
+				//Warm start, nothing to compile
+				*build.target = build.program;
+				build.state = SHADER_DONE;
+				fromCache++;
+				break;
+			}
+
+			//A rejected binary can leave the program in a state that won't link, start over
+			glDeleteProgram(build.program);
+			build.program = glCreateProgram();
+
+			build.vert = compile(*build.vertSource, GL_VERTEX_SHADER, build.defines);
+			build.frag = compile(*build.fragSource, GL_FRAGMENT_SHADER, build.defines);
+			build.state = SHADER_COMPILING;
+			break;
+		}
+
+		case SHADER_COMPILING: {
+			if (!shaderReady(build.vert, parallel) || !shaderReady(build.frag, parallel))
+				break;
+
+			//Check both so both logs get printed
+			bool vertCompiled = compiled(build.vert, build.vertFile);
+			bool fragCompiled = compiled(build.frag, build.fragFile);
+			if (!vertCompiled || !fragCompiled) {
+				failed++;
+				fail(build);
+				break;
+			}
+
+			glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glAttachShader(build.program, build.vert);
+			glAttachShader(build.program, build.frag);
+			glLinkProgram(build.program);
+			build.state = SHADER_LINKING;
+			break;
+		}
+
+		case SHADER_LINKING: {
+			if (!programReady(build.program, parallel))
+				break;
+
+			GLint success;
+			glGetProgramiv(build.program, GL_LINK_STATUS, &success);
+			if (!success) {
+				GLint length = 0;
+				glGetProgramiv(build.program, GL_INFO_LOG_LENGTH, &length);
+				std::string infoLog(length > 0 ? length : 1, '\0');
+				glGetProgramInfoLog(build.program, (GLsizei)infoLog.size(), NULL, &infoLog[0]);
+				std::cout << "Error: Shader linking failed. Program: " << build.program << ", Vert File: " << build.vertFile << ", Frag File: " << build.fragFile << " Details:\n" << infoLog.c_str() << std::endl;
+
+				failed++;
+				fail(build);
+				break;
+			}
+
+			shaderCache.store(build.key, build.program);
+
+			//The program keeps what it linked, the shader objects aren't needed any more
+			glDetachShader(build.program, build.vert);
+			glDetachShader(build.program, build.frag);
+			glDeleteShader(build.vert);
+			glDeleteShader(build.frag);
+			build.vert = build.frag = 0;
+
+			*build.target = build.program;
+			build.state = SHADER_DONE;
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		if (build.state != SHADER_DONE && build.state != SHADER_FAILED)
+			done = false;
+	}
+
+	if (done && !finished) {
+		finished = true;
+		shaderCache.save();
+
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+		std::cout << "Built " << builds.size() << " shader programs in " << ms << " ms (" << fromCache << " from cache, "
+			<< (parallel ? "parallel" : "serial") << " compile)" << std::endl;
+	}
+
+	return done;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "AssetManager.h"
+
+//KHR_parallel_shader_compile isn't in our glad, and ARB_parallel_shader_compile uses the same value
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+enum ShaderBuildState {
+	SHADER_WAITING, //Sources still coming from the AssetManager
+	SHADER_COMPILING, //Both stages submitted, status not asked for yet
+	SHADER_LINKING,
+	SHADER_DONE,
+	SHADER_FAILED
+};
+
+struct ShaderBuild {
+	GLuint* target; //Only written once the program has linked, so nothing can draw with a half built one
+	std::string vertFile, fragFile;
+	std::string defines; //"#define NAME\n" lines, go in after each file's #version
+	std::shared_ptr<FileAsset> vertSource, fragSource;
+	uint64_t key = 0; //ShaderCache key
+	GLuint program = 0, vert = 0, frag = 0;
+	int state = SHADER_WAITING;
+};
+
+//Builds every program at once instead of compile, wait, compile, wait.
+//Asking for compile or link status blocks until the driver is done, so update() submits everything it can first
+//and only asks about stages the driver says are finished. With KHR/ARB_parallel_shader_compile the driver compiles on
+//its own threads and we can poll GL_COMPLETION_STATUS_KHR, without it we at least never ask before every compile
+//and link has been submitted. Programs found in shaderCache skip all of that.
+struct ShaderBuilder {
+	std::vector<ShaderBuild> builds;
+	bool parallel = false; //Driver has KHR or ARB_parallel_shader_compile
+	bool finished = false;
+	int failed = 0, fromCache = 0;
+	std::chrono::steady_clock::time_point startTime;
+
+	//Needs the GL context, asks the driver for as many compiler threads as it likes
+	void init();
+
+	//Queues a program, program is set once update() has it linked
+	void add(GLuint& program, const std::string& vertFile, const std::string& fragFile, const std::string& defines = "");
+
+	//Moves every build along as far as it can go without blocking, true once they're all done or failed
+	bool update();
+};
+
+extern ShaderBuilder shaderBuilder;
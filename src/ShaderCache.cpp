@@ -0,0 +1,141 @@
+#include "ShaderCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+ShaderCache shaderCache;
+
+uint64_t ShaderCache::hash(uint64_t seed, const void* data, size_t size) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++) {
+		seed ^= bytes[i];
+		seed *= 0x100000001b3ull;
+	}
+
+	return seed;
+}
+
+//Hashes a GL string plus a separator, so "ab" + "c" and "a" + "bc" differ
+static uint64_t hashString(uint64_t seed, GLenum name) {
+	const char* value = (const char*)glGetString(name);
+	if (value)
+		seed = ShaderCache::hash(seed, value, strlen(value));
+
+	return ShaderCache::hash(seed, "|", 1);
+}
+
+void ShaderCache::init(const std::string& path) {
+	this->path = path;
+
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	enabled = formats > 0;
+	if (!enabled)
+		return;
+
+	driverHash = 0xcbf29ce484222325ull;
+	driverHash = hashString(driverHash, GL_VENDOR);
+	driverHash = hashString(driverHash, GL_RENDERER);
+	driverHash = hashString(driverHash, GL_VERSION);
+
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return; //First run
+
+	uint32_t header[3];
+	if (!in.read((char*)header, sizeof(header)) || header[0] != MAGIC || header[1] != VERSION)
+		return; //Some other version's cache, it gets replaced on save()
+
+	for (uint32_t i = 0; i < header[2]; i++) {
+		uint64_t key;
+		uint32_t format, size;
+		if (!in.read((char*)&key, sizeof(key)) || !in.read((char*)&format, sizeof(format)) || !in.read((char*)&size, sizeof(size)))
+			break;
+
+		Entry& entry = entries[key];
+		entry.format = format;
+		entry.binary.resize(size);
+		if (!in.read((char*)entry.binary.data(), size)) {
+			entries.erase(key); //Truncated, keep what came before it
+			break;
+		}
+	}
+}
+
+bool ShaderCache::load(uint64_t key, GLuint program) {
+	if (!enabled)
+		return false;
+
+	auto found = entries.find(key);
+	if (found == entries.end()) {
+		misses++;
+		return false;
+	}
+
+	Entry& entry = found->second;
+	glProgramBinary(program, entry.format, entry.binary.data(), (GLsizei)entry.binary.size());
+
+	//Drivers are allowed to reject binaries for any reason, even ones they wrote
+	GLint linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		entries.erase(found);
+		dirty = true;
+		misses++;
+		return false;
+	}
+
+	entry.used = true;
+	hits++;
+	return true;
+}
+
+void ShaderCache::store(uint64_t key, GLuint program) {
+	if (!enabled)
+		return;
+
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return;
+
+	Entry& entry = entries[key];
+	entry.binary.resize(size);
+	glGetProgramBinary(program, size, NULL, &entry.format, entry.binary.data());
+	entry.used = true;
+	dirty = true;
+}
+
+void ShaderCache::save() {
+	//Unused entries are dropped, so a cache that had any is worth rewriting too
+	uint32_t count = 0;
+	for (auto& pair : entries)
+		if (pair.second.used)
+			count++;
+
+	if (!enabled || (!dirty && count == entries.size()))
+		return;
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out) {
+		std::cout << "Error: Failed to write shader cache " << path << std::endl;
+		return;
+	}
+
+	uint32_t header[3] = { MAGIC, VERSION, count };
+	out.write((const char*)header, sizeof(header));
+
+	for (auto& pair : entries) {
+		if (!pair.second.used)
+			continue;
+
+		uint32_t format = pair.second.format, size = (uint32_t)pair.second.binary.size();
+		out.write((const char*)&pair.first, sizeof(pair.first));
+		out.write((const char*)&format, sizeof(format));
+		out.write((const char*)&size, sizeof(size));
+		out.write((const char*)pair.second.binary.data(), size);
+	}
+
+	dirty = false;
+}
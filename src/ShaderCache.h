@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+//Linked program binaries from earlier runs, so a warm start skips compiling and linking entirely.
+//Everything lives in one file, read at init() and written back by save(). An entry's key hashes the sources, the
+//defines and the driver's vendor, renderer and version strings, so any change to those just misses and compiles again.
+//Only entries used this run are saved, so ones for old sources or old drivers drop out by themselves.
+struct ShaderCache {
+	static const uint32_t MAGIC = 0x48435350; //"PSCH"
+	static const uint32_t VERSION = 1;
+
+	struct Entry {
+		GLenum format = 0;
+		std::vector<unsigned char> binary;
+		bool used = false;
+	};
+
+	std::string path;
+	std::map<uint64_t, Entry> entries;
+	uint64_t driverHash = 0;
+	bool enabled = false; //Driver supports at least one binary format
+	bool dirty = false;
+	int hits = 0, misses = 0;
+
+	//Needs the GL context, reads path if it exists
+	void init(const std::string& path);
+
+	//Start of a key, fold each source and the defines into it with hash()
+	uint64_t begin() const { return driverHash; }
+
+	//FNV-1a, seed is the running hash
+	static uint64_t hash(uint64_t seed, const void* data, size_t size);
+
+	//glProgramBinary into program, false if there's no entry or the driver rejects it. The program needs a new
+	//glCreateProgram before it can be linked from source after a rejected binary
+	bool load(uint64_t key, GLuint program);
+
+	//Call on a linked program made with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	void store(uint64_t key, GLuint program);
+
+	//Writes the file if anything changed
+	void save();
+};
+
+extern ShaderCache shaderCache;
@@ -0,0 +1,66 @@
+#include "ShaderPermutations.h"
+#include "ShaderBuilder.h"
+#include "GLState.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+ShaderPermutations shaders;
+
+struct ShaderSource {
+	const char* vertFile;
+	const char* fragFile;
+};
+
+//Indexed by ShaderId
+static const ShaderSource SHADER_SOURCES[SHADER_COUNT] = {
+	{ "src/shaders/vertex.vert", "src/shaders/fragment.frag" },
+	{ "src/shaders/post.vert", "src/shaders/bloom.frag" },
+	{ "src/shaders/post.vert", "src/shaders/post.frag" },
+	{ "src/shaders/particle.vert", "src/shaders/particle.frag" }
+};
+
+//Indexed by feature bit
+static const char* FEATURE_NAMES[SHADER_FEATURE_BITS] = { "COLORED", "TEXTURED", "SDF", "BRIGHT_PASS", "CRT", "BLOOM", "SCANLINES" };
+
+std::string ShaderPermutations::defines(uint32_t features) {
+	std::string defines;
+	for (int i = 0; i < SHADER_FEATURE_BITS; i++)
+		if (features & (1 << i))
+			defines += std::string("#define ") + FEATURE_NAMES[i] + "\n";
+
+	return defines;
+}
+
+GLuint ShaderPermutations::build(ShaderId shader, uint32_t features, bool wait) {
+	uint32_t key = permutationKey(shader, features);
+
+	if (!requested[key]) {
+		requested[key] = true;
+		shaderBuilder.add(programs[key], SHADER_SOURCES[shader].vertFile, SHADER_SOURCES[shader].fragFile, defines(features));
+
+		if (wait)
+			std::cout << "Compiling shader variant " << key << " on demand, require() it at startup instead" << std::endl;
+	}
+
+	//If it failed, shaderBuilder finishes without ever setting it
+	while (wait && programs[key] == 0 && !shaderBuilder.update())
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	if (wait && programs[key] == 0) {
+		//shaderBuilder already logged why, just make sure we don't go through this every frame
+		failed[key] = true;
+		std::cout << "Error: Shader variant " << key << " is unusable, drawing with it does nothing" << std::endl;
+	}
+
+	return programs[key];
+}
+
+void ShaderPermutations::destroy() {
+	for (GLuint& program : programs) {
+		if (program)
+			glState.deleteProgram(program);
+		program = 0;
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+#include <glad/glad.h>
+
+//Every shader source pair, see SHADER_SOURCES in ShaderPermutations.cpp
+enum ShaderId {
+	SHADER_QUAD, //vertex.vert + fragment.frag, everything QuadBatch draws, glyphs included
+	SHADER_BLOOM_DOWNSAMPLE, //post.vert + bloom.frag, one step of PostProcess's bloom chain
+	SHADER_POST, //post.vert + post.frag, PostProcess's fused pass
+	SHADER_PARTICLE, //particle.vert + particle.frag, ParticleSystem's instances
+	SHADER_COUNT
+};
+
+//Each feature is a #define the sources check with #ifdef, so a variant only has the code it uses instead of branching
+enum ShaderFeature : uint32_t {
+	SHADER_COLORED = 1 << 0, //COLORED, multiply by the per-quad color
+	SHADER_TEXTURED = 1 << 1, //TEXTURED, sample the bound texture
+	SHADER_SDF = 1 << 2, //SDF, with TEXTURED, the texture's alpha is a distance field rather than coverage
+	SHADER_BRIGHT_PASS = 1 << 3, //BRIGHT_PASS, keep only what's bright enough to bloom
+	SHADER_CRT = 1 << 4, //CRT, curved glass and vignette
+	SHADER_BLOOM = 1 << 5, //BLOOM, add the bloom chain
+	SHADER_SCANLINES = 1 << 6 //SCANLINES, darken between lines
+};
+
+const int SHADER_FEATURE_BITS = 7;
+
+//Features each source actually has #ifdefs for
+constexpr uint32_t shaderFeatures(ShaderId shader) {
+	return shader == SHADER_QUAD ? SHADER_COLORED | SHADER_TEXTURED | SHADER_SDF :
+		shader == SHADER_BLOOM_DOWNSAMPLE ? SHADER_BRIGHT_PASS :
+		shader == SHADER_POST ? SHADER_CRT | SHADER_BLOOM | SHADER_SCANLINES : 0;
+}
+
+//Unique per variant, also the index into ShaderPermutations::programs
+constexpr uint32_t permutationKey(ShaderId shader, uint32_t features) {
+	return (uint32_t)shader << SHADER_FEATURE_BITS | features;
+}
+
+//One program per (source, feature set) that's been asked for, compiled the first time it is.
+//Draw code picks its variant with get<SHADER_QUAD, SHADER_COLORED>(), which is checked at compile time and comes down
+//to one array load. Variants that are known up front should be require()d during startup so they build alongside
+//everything else, get() on one that wasn't has to compile it there and then.
+struct ShaderPermutations {
+	GLuint programs[SHADER_COUNT << SHADER_FEATURE_BITS] = {};
+	bool requested[SHADER_COUNT << SHADER_FEATURE_BITS] = {};
+	bool failed[SHADER_COUNT << SHADER_FEATURE_BITS] = {}; //Didn't compile or link, get() returns 0 without trying again
+	bool enabled = false; //No GL in software mode, every program stays 0
+
+	void init() { enabled = true; }
+
+	template<ShaderId Shader, uint32_t Features>
+	GLuint get() {
+		static_assert((Features & ~shaderFeatures(Shader)) == 0, "Shader doesn't have that feature");
+		const uint32_t key = permutationKey(Shader, Features);
+
+		GLuint program = programs[key];
+		if (program != 0 || !enabled || failed[key])
+			return program;
+
+		return build(Shader, Features, true);
+	}
+
+	//Queues a variant on shaderBuilder without waiting for it
+	template<ShaderId Shader, uint32_t Features>
+	void require() {
+		static_assert((Features & ~shaderFeatures(Shader)) == 0, "Shader doesn't have that feature");
+		if (enabled)
+			build(Shader, Features, false);
+	}
+
+	//For variants picked at runtime, like the post effects from the command line. Same as the templates, with the
+	//feature check moved to an assert
+	GLuint get(ShaderId shader, uint32_t features) {
+		assert((features & ~shaderFeatures(shader)) == 0);
+		const uint32_t key = permutationKey(shader, features);
+		GLuint program = programs[key];
+		if (program != 0 || !enabled || failed[key])
+			return program;
+
+		return build(shader, features, true);
+	}
+
+	void require(ShaderId shader, uint32_t features) {
+		assert((features & ~shaderFeatures(shader)) == 0);
+		if (enabled)
+			build(shader, features, false);
+	}
+
+	//Slow path, wait = true blocks until it's linked. Returns the program, 0 if it failed or isn't done yet
+	GLuint build(ShaderId shader, uint32_t features, bool wait);
+
+	//"#define COLORED\n..." for a feature set
+	static std::string defines(uint32_t features);
+
+	void destroy();
+};
+
+extern ShaderPermutations shaders;
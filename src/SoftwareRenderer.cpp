@@ -0,0 +1,464 @@
+#include "SoftwareRenderer.h"
+#include "QuadBatch.h"
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <emmintrin.h> //SSE2
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#define GLFW_EXPOSE_NATIVE_WIN32
+#include <GLFW/glfw3native.h>
+#elif defined(__linux__)
+#include <X11/Xlib.h>
+#define GLFW_EXPOSE_NATIVE_X11
+#include <GLFW/glfw3native.h>
+#endif
+
+static const int PARTICLE_CHUNK = 16384; //Particles per job when binning
+
+static uint32_t packColor(float r, float g, float b, float a) {
+	uint32_t ri = (uint32_t)(std::min(std::max(r, 0.0f), 1.0f) * 255.0f + 0.5f);
+	uint32_t gi = (uint32_t)(std::min(std::max(g, 0.0f), 1.0f) * 255.0f + 0.5f);
+	uint32_t bi = (uint32_t)(std::min(std::max(b, 0.0f), 1.0f) * 255.0f + 0.5f);
+	uint32_t ai = (uint32_t)(std::min(std::max(a, 0.0f), 1.0f) * 255.0f + 0.5f);
+	return ri | (gi << 8) | (bi << 16) | (ai << 24);
+}
+
+void SoftwareRenderer::init(int width, int height, ThreadPool* pool) {
+	this->width = width;
+	this->height = height;
+	this->pool = pool;
+
+	pixels.assign(width * height, 0);
+	tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	bins.resize(tilesX * tilesY);
+}
+
+GLuint SoftwareRenderer::addTexture(const unsigned char* data, int width, int height, int channels) {
+	SoftTexture texture;
+	texture.width = width;
+	texture.height = height;
+	texture.pixels.resize(width * height);
+
+	for (int i = 0; i < width * height; i++) {
+		const unsigned char* p = data + i * channels;
+		unsigned char r = p[0];
+		unsigned char g = channels > 1 ? p[1] : r;
+		unsigned char b = channels > 2 ? p[2] : r;
+		unsigned char a = channels > 3 ? p[3] : (channels == 2 ? p[1] : 255);
+		texture.pixels[i] = r | (g << 8) | (b << 16) | ((uint32_t)a << 24);
+	}
+
+	textures.push_back(std::move(texture));
+	return (GLuint)textures.size();
+}
+
+GLuint SoftwareRenderer::createTexture(int width, int height) {
+	SoftTexture texture;
+	texture.width = width;
+	texture.height = height;
+	texture.pixels.assign((size_t)width * height, 0);
+
+	textures.push_back(std::move(texture));
+	return (GLuint)textures.size();
+}
+
+void SoftwareRenderer::updateTexture(GLuint texture, int x, int y, int width, int height, const uint32_t* pixels, int stride) {
+	SoftTexture& dest = textures[texture - 1];
+	for (int row = 0; row < height; row++)
+		memcpy(dest.pixels.data() + (size_t)(y + row) * dest.width + x, pixels + (size_t)row * stride, width * sizeof(uint32_t));
+}
+
+void SoftwareRenderer::destroyTexture(GLuint texture) {
+	//Ids are indices, so the slot stays, just without its pixels
+	textures[texture - 1] = SoftTexture();
+}
+
+void SoftwareRenderer::prepare(const RenderCommand& command) {
+	Prepared p = {};
+	p.type = command.type;
+	p.blend = command.blend;
+	p.color = packColor(command.r, command.g, command.b, command.a);
+	p.alpha = (int)(std::min(std::max(command.a, 0.0f), 1.0f) * 256.0f + 0.5f);
+
+	if (command.type == COMMAND_CLEAR) {
+		p.x0 = p.y0 = 0;
+		p.x1 = width;
+		p.y1 = height;
+	}
+	else {
+		//NDC to pixels, y flipped since row 0 is the top. A pixel is covered if its center is inside the quad
+		float left = (command.x + 1.0f) * 0.5f * width;
+		float right = (command.x + command.width + 1.0f) * 0.5f * width;
+		float top = (1.0f - (command.y + command.height)) * 0.5f * height;
+		float bottom = (1.0f - command.y) * 0.5f * height;
+
+		p.x0 = std::max(0, (int)std::ceil(left - 0.5f));
+		p.x1 = std::min(width, (int)std::ceil(right - 0.5f));
+		p.y0 = std::max(0, (int)std::ceil(top - 0.5f));
+		p.y1 = std::min(height, (int)std::ceil(bottom - 0.5f));
+		if (p.x0 >= p.x1 || p.y0 >= p.y1)
+			return;
+
+		if (command.texture > 0 && command.texture <= textures.size() && textures[command.texture - 1].width > 0) {
+			p.texture = &textures[command.texture - 1];
+
+			//u goes left to right, v goes bottom to top, both linear in pixels
+			p.du = (command.u1 - command.u0) / (right - left);
+			p.dv = -(command.v1 - command.v0) / (bottom - top);
+			p.u = command.u0 + (p.x0 + 0.5f - left) * p.du;
+			p.v = command.v1 + (p.y0 + 0.5f - top) * p.dv;
+		}
+	}
+
+	uint32_t index = (uint32_t)prepared.size();
+	prepared.push_back(p);
+
+	for (int ty = p.y0 / TILE_SIZE; ty <= (p.y1 - 1) / TILE_SIZE; ty++) {
+		for (int tx = p.x0 / TILE_SIZE; tx <= (p.x1 - 1) / TILE_SIZE; tx++)
+			bins[ty * tilesX + tx].push_back(index);
+	}
+}
+
+//Pixels a particle covers, same rule as quads in prepare(). False if it covers none or has faded out
+static bool particleRect(const ParticleInstance& particle, float aspect, int width, int height, int& x0, int& y0, int& x1, int& y1) {
+	if ((particle.color >> 24) == 0)
+		return false;
+
+	float halfWidth = particle.size * aspect * 0.5f, halfHeight = particle.size * 0.5f;
+	x0 = std::max(0, (int)std::ceil((particle.x - halfWidth + 1.0f) * 0.5f * width - 0.5f));
+	x1 = std::min(width, (int)std::ceil((particle.x + halfWidth + 1.0f) * 0.5f * width - 0.5f));
+	y0 = std::max(0, (int)std::ceil((1.0f - (particle.y + halfHeight)) * 0.5f * height - 0.5f));
+	y1 = std::min(height, (int)std::ceil((1.0f - (particle.y - halfHeight)) * 0.5f * height - 0.5f));
+	return x0 < x1 && y0 < y1;
+}
+
+void SoftwareRenderer::prepareParticles(const RenderCommand& command) {
+	const ParticleSystem& system = *command.particles;
+	if (system.drawCount == 0)
+		return;
+
+	if (particleBinsUsed == (int)particleBins.size())
+		particleBins.emplace_back();
+	ParticleBins& binned = particleBins[particleBinsUsed];
+
+	const int tiles = tilesX * tilesY;
+	const int chunks = (system.drawCount + PARTICLE_CHUNK - 1) / PARTICLE_CHUNK;
+	binned.counts.assign((size_t)chunks * tiles, 0);
+
+	//Each chunk only touches its own row of counts, so chunks run in parallel without locking
+	auto forEachTile = [this, &system](int chunk, uint32_t* row, ParticleBins::Span* spans) {
+		int end = std::min(system.drawCount, (chunk + 1) * PARTICLE_CHUNK);
+		for (int i = chunk * PARTICLE_CHUNK; i < end; i++) {
+			const ParticleInstance& particle = system.instances[i];
+			int x0, y0, x1, y1;
+			if (!particleRect(particle, system.aspect, width, height, x0, y0, x1, y1))
+				continue;
+
+			for (int ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ty++) {
+				for (int tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; tx++) {
+					uint32_t& slot = row[ty * tilesX + tx];
+					if (spans) {
+						ParticleBins::Span& span = spans[slot];
+						span.x0 = (uint16_t)std::max(x0, tx * TILE_SIZE);
+						span.x1 = (uint16_t)std::min(x1, (tx + 1) * TILE_SIZE);
+						span.y0 = (uint16_t)std::max(y0, ty * TILE_SIZE);
+						span.y1 = (uint16_t)std::min(y1, (ty + 1) * TILE_SIZE);
+						span.color = particle.color;
+					}
+					slot++;
+				}
+			}
+		}
+	};
+	auto countChunk = [&](int chunk) { forEachTile(chunk, binned.counts.data() + (size_t)chunk * tiles, nullptr); };
+	auto writeChunk = [&](int chunk) { forEachTile(chunk, binned.counts.data() + (size_t)chunk * tiles, binned.spans.data()); };
+
+	if (pool && chunks > 1)
+		pool->parallelFor(chunks, countChunk);
+	else {
+		for (int chunk = 0; chunk < chunks; chunk++)
+			countChunk(chunk);
+	}
+
+	//Tile by tile, then chunk by chunk inside a tile, so each tile's particles stay in order.
+	//Counts become where each chunk starts writing
+	binned.start.resize(tiles + 1);
+	uint32_t total = 0;
+	for (int tile = 0; tile < tiles; tile++) {
+		binned.start[tile] = total;
+		for (int chunk = 0; chunk < chunks; chunk++) {
+			uint32_t& count = binned.counts[(size_t)chunk * tiles + tile];
+			uint32_t chunkCount = count;
+			count = total;
+			total += chunkCount;
+		}
+	}
+	binned.start[tiles] = total;
+	binned.spans.resize(total);
+
+	if (pool && chunks > 1)
+		pool->parallelFor(chunks, writeChunk);
+	else {
+		for (int chunk = 0; chunk < chunks; chunk++)
+			writeChunk(chunk);
+	}
+
+	Prepared p = {};
+	p.type = COMMAND_PARTICLES;
+	p.blend = command.blend;
+	p.x1 = width;
+	p.y1 = height;
+	p.particles = particleBinsUsed++;
+
+	uint32_t index = (uint32_t)prepared.size();
+	prepared.push_back(p);
+	for (int tile = 0; tile < tiles; tile++) {
+		if (binned.start[tile + 1] > binned.start[tile])
+			bins[tile].push_back(index);
+	}
+}
+
+void SoftwareRenderer::render(const std::vector<RenderCommand>& commands, const std::vector<RenderQueue::SortEntry>& order) {
+	prepared.clear();
+	particleBinsUsed = 0;
+	for (std::vector<uint32_t>& bin : bins)
+		bin.clear();
+
+	//Convert to pixel space and bin, in draw order so each tile's list is already sorted
+	for (const RenderQueue::SortEntry& entry : order) {
+		const RenderCommand& command = commands[entry.index];
+
+		if (command.type == COMMAND_PARTICLES) {
+			prepareParticles(command);
+			continue;
+		}
+
+		if (command.type != COMMAND_QUAD_LIST) {
+			prepare(command);
+			continue;
+		}
+
+		//No buffers to keep here, lists just become plain quads with the list's state
+		RenderCommand quad = command;
+		quad.type = COMMAND_QUAD;
+		for (const QuadBatch::Instance& instance : command.list->instances) {
+			quad.x = instance.x;
+			quad.y = instance.y;
+			quad.width = instance.width;
+			quad.height = instance.height;
+			quad.r = instance.r;
+			quad.g = instance.g;
+			quad.b = instance.b;
+			quad.a = instance.a;
+			quad.u0 = instance.u0;
+			quad.v0 = instance.v0;
+			quad.u1 = instance.u1;
+			quad.v1 = instance.v1;
+			prepare(quad);
+		}
+	}
+
+	if (pool)
+		pool->parallelFor(tilesX * tilesY, [this](int tile) { rasterizeTile(tile); });
+	else {
+		for (int tile = 0; tile < tilesX * tilesY; tile++)
+			rasterizeTile(tile);
+	}
+}
+
+//Writes color over count pixels, 4 at a time
+static void fillSpan(uint32_t* row, int count, uint32_t color) {
+	__m128i c = _mm_set1_epi32((int)color);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i*)(row + i), c);
+	for (; i < count; i++)
+		row[i] = color;
+}
+
+//row = row * (256 - alpha) / 256 + color * alpha / 256 per channel, 4 pixels at a time
+static void blendSpan(uint32_t* row, int count, uint32_t color, int alpha) {
+	__m128i zero = _mm_setzero_si128();
+	__m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+	src = _mm_mullo_epi16(src, _mm_set1_epi16((short)alpha)); //Premultiplied once for the whole span
+	__m128i inverse = _mm_set1_epi16((short)(256 - alpha));
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i dst = _mm_loadu_si128((const __m128i*)(row + i));
+		__m128i lo = _mm_unpacklo_epi8(dst, zero);
+		__m128i hi = _mm_unpackhi_epi8(dst, zero);
+
+		lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, inverse), src), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, inverse), src), 8);
+
+		_mm_storeu_si128((__m128i*)(row + i), _mm_packus_epi16(lo, hi));
+	}
+
+	for (; i < count; i++) {
+		uint32_t d = row[i], result = 0;
+		for (int shift = 0; shift < 32; shift += 8) {
+			uint32_t dc = (d >> shift) & 0xFF, sc = (color >> shift) & 0xFF;
+			result |= ((dc * (256 - alpha) + sc * alpha) >> 8) << shift;
+		}
+		row[i] = result;
+	}
+}
+
+//row = saturate(row + color * alpha / 256) per channel, 4 pixels at a time
+static void addSpan(uint32_t* row, int count, uint32_t color, int alpha) {
+	uint32_t scaled = 0;
+	for (int shift = 0; shift < 32; shift += 8)
+		scaled |= ((((color >> shift) & 0xFF) * alpha) >> 8) << shift;
+	__m128i src = _mm_set1_epi32((int)scaled);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i dst = _mm_loadu_si128((const __m128i*)(row + i));
+		_mm_storeu_si128((__m128i*)(row + i), _mm_adds_epu8(dst, src));
+	}
+
+	for (; i < count; i++)
+		row[i] = (uint32_t)_mm_cvtsi128_si32(_mm_adds_epu8(_mm_cvtsi32_si128((int)row[i]), src));
+}
+
+//Nearest texel times color, then blended like the untextured spans. Scalar, gathers don't vectorize well on SSE2
+static void textureSpan(uint32_t* row, int count, const SoftwareRenderer::Prepared& p, float u, float v) {
+	const SoftwareRenderer::SoftTexture& texture = *p.texture;
+
+	int ty = (int)std::floor(v * texture.height) % texture.height;
+	if (ty < 0) ty += texture.height; //GL_REPEAT
+	const uint32_t* texels = texture.pixels.data() + ty * texture.width;
+
+	for (int i = 0; i < count; i++, u += p.du) {
+		int tx = (int)std::floor(u * texture.width) % texture.width;
+		if (tx < 0) tx += texture.width;
+
+		uint32_t texel = texels[tx], tinted = 0;
+		for (int shift = 0; shift < 32; shift += 8)
+			tinted |= ((((texel >> shift) & 0xFF) * ((p.color >> shift) & 0xFF) + 127) / 255) << shift;
+
+		int alpha = (int)(tinted >> 24);
+		alpha += alpha >> 7; //0-255 to 0-256
+
+		if (p.blend == BLEND_OPAQUE)
+			row[i] = tinted;
+		else if (p.blend == BLEND_ADDITIVE)
+			addSpan(row + i, 1, tinted, alpha);
+		else
+			blendSpan(row + i, 1, tinted, alpha);
+	}
+}
+
+void SoftwareRenderer::rasterizeTile(int tile) {
+	int tileX0 = (tile % tilesX) * TILE_SIZE, tileY0 = (tile / tilesX) * TILE_SIZE;
+	int tileX1 = std::min(tileX0 + TILE_SIZE, width), tileY1 = std::min(tileY0 + TILE_SIZE, height);
+
+	for (uint32_t index : bins[tile]) {
+		const Prepared& p = prepared[index];
+
+		if (p.type == COMMAND_PARTICLES) {
+			//Flat squares, there's no shader to round them off
+			const ParticleBins& binned = particleBins[p.particles];
+			for (uint32_t i = binned.start[tile]; i < binned.start[tile + 1]; i++) {
+				const ParticleBins::Span& span = binned.spans[i];
+				int alpha = (int)(span.color >> 24);
+				alpha += alpha >> 7; //0-255 to 0-256
+
+				for (int y = span.y0; y < span.y1; y++) {
+					uint32_t* row = pixels.data() + y * width + span.x0;
+					if (p.blend == BLEND_ADDITIVE)
+						addSpan(row, span.x1 - span.x0, span.color, alpha);
+					else
+						blendSpan(row, span.x1 - span.x0, span.color, alpha);
+				}
+			}
+			continue;
+		}
+
+		int x0 = std::max(p.x0, tileX0), x1 = std::min(p.x1, tileX1);
+		int y0 = std::max(p.y0, tileY0), y1 = std::min(p.y1, tileY1);
+		int count = x1 - x0;
+
+		for (int y = y0; y < y1; y++) {
+			uint32_t* row = pixels.data() + y * width + x0;
+
+			if (p.texture)
+				textureSpan(row, count, p, p.u + (x0 - p.x0) * p.du, p.v + (y - p.y0) * p.dv);
+			else if (p.type == COMMAND_CLEAR || p.blend == BLEND_OPAQUE || p.alpha >= 256)
+				fillSpan(row, count, p.color);
+			else if (p.blend == BLEND_ADDITIVE)
+				addSpan(row, count, p.color, p.alpha);
+			else
+				blendSpan(row, count, p.color, p.alpha);
+		}
+	}
+}
+
+void SoftwareRenderer::present(GLFWwindow* window) {
+#if defined(_WIN32) || defined(__linux__)
+	//GDI and X11's 24 bit visuals both want BGRA, so swap red and blue
+	presentPixels.resize(pixels.size());
+	const __m128i redBlue = _mm_set1_epi32(0x00FF00FF), greenAlpha = _mm_set1_epi32((int)0xFF00FF00);
+	size_t i = 0;
+	for (; i + 4 <= pixels.size(); i += 4) {
+		__m128i p = _mm_loadu_si128((const __m128i*)(pixels.data() + i));
+		__m128i rb = _mm_and_si128(p, redBlue);
+		rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+		_mm_storeu_si128((__m128i*)(presentPixels.data() + i), _mm_or_si128(_mm_and_si128(p, greenAlpha), rb));
+	}
+	for (; i < pixels.size(); i++) {
+		uint32_t p = pixels[i];
+		presentPixels[i] = (p & 0xFF00FF00) | ((p & 0xFF) << 16) | ((p >> 16) & 0xFF);
+	}
+#endif
+
+#ifdef _WIN32
+	BITMAPINFO info = {};
+	info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	info.bmiHeader.biWidth = width;
+	info.bmiHeader.biHeight = -height; //Negative means row 0 is the top
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = 32;
+	info.bmiHeader.biCompression = BI_RGB;
+
+	HWND hwnd = glfwGetWin32Window(window);
+	HDC dc = GetDC(hwnd);
+	RECT client;
+	GetClientRect(hwnd, &client);
+	StretchDIBits(dc, 0, 0, client.right, client.bottom, 0, 0, width, height, presentPixels.data(), &info, DIB_RGB_COLORS, SRCCOPY);
+	ReleaseDC(hwnd, dc);
+#elif defined(__linux__)
+	//The window is fullscreen at our size, so no scaling, XPutImage just copies. The image only borrows presentPixels
+	Display* display = glfwGetX11Display();
+	XImage image = {};
+	image.width = width;
+	image.height = height;
+	image.format = ZPixmap;
+	image.data = (char*)presentPixels.data();
+	image.byte_order = LSBFirst;
+	image.bitmap_unit = 32;
+	image.bitmap_bit_order = LSBFirst;
+	image.bitmap_pad = 32;
+	image.depth = 24;
+	image.bytes_per_line = width * 4;
+	image.bits_per_pixel = 32;
+	image.red_mask = 0xFF0000;
+	image.green_mask = 0xFF00;
+	image.blue_mask = 0xFF;
+	XInitImage(&image);
+
+	XPutImage(display, glfwGetX11Window(window), DefaultGC(display, DefaultScreen(display)), &image, 0, 0, 0, 0, width, height);
+	XFlush(display);
+#else
+	(void)window;
+#endif
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderBackend.h"
+#include "ThreadPool.h"
+
+//CPU backend for machines with no GPU or GL driver. Commands are binned into screen tiles, then the tiles are
+//rasterized in parallel on the thread pool with SSE2 span fills into an RGBA framebuffer.
+//Shader programs are ignored, a quad is its color times its texture (if any).
+struct SoftwareRenderer : RenderBackend {
+	static const int TILE_SIZE = 64;
+
+	struct SoftTexture {
+		int width = 0, height = 0;
+		std::vector<uint32_t> pixels; //RGBA, row 0 is v = 0 like a GL upload
+	};
+
+	//A command converted to pixel space, built once per frame and shared by every tile it touches
+	struct Prepared {
+		RenderCommandType type;
+		BlendMode blend;
+		int x0, y0, x1, y1; //Covered pixels, x1 and y1 exclusive
+		uint32_t color; //RGBA8, alpha included
+		int alpha; //0 to 256
+		const SoftTexture* texture;
+		float u, v, du, dv; //Texture coords at the center of pixel (x0, y0), and their step per pixel
+		int particles; //COMMAND_PARTICLES only, index into particleBins
+	};
+
+	//A particle system binned by tile. It's one Prepared entry in each tile it touches, and the tile rasterizes its
+	//particles from here when it gets to that entry, so a million particles don't each become a Prepared
+	struct ParticleBins {
+		//A particle's pixels inside one tile, so rasterizing reads them in order instead of chasing instances
+		struct Span {
+			uint16_t x0, y0, x1, y1;
+			uint32_t color; //RGBA8
+		};
+
+		std::vector<uint32_t> counts; //Per chunk of particles and tile, then each chunk's write position per tile
+		std::vector<uint32_t> start; //Per tile, where its particles start in spans, one extra for the end
+		std::vector<Span> spans; //Grouped by tile
+	};
+
+	int width = 0, height = 0;
+	std::vector<uint32_t> pixels; //RGBA8 in memory order, row 0 is the top of the screen
+	std::vector<uint32_t> presentPixels; //BGRA copy for GDI
+
+	int tilesX = 0, tilesY = 0;
+	std::vector<std::vector<uint32_t>> bins; //Indices into prepared, in draw order, per tile
+	std::vector<Prepared> prepared;
+	std::vector<ParticleBins> particleBins; //Kept between frames so binning doesn't allocate
+	int particleBinsUsed = 0;
+
+	std::vector<SoftTexture> textures; //Texture id is index + 1, 0 means untextured
+	ThreadPool* pool = nullptr;
+
+	void init(int width, int height, ThreadPool* pool);
+
+	//Copies the pixels, returns the id to put in RenderCommand::texture
+	GLuint addTexture(const unsigned char* data, int width, int height, int channels);
+
+	void render(const std::vector<RenderCommand>& commands, const std::vector<RenderQueue::SortEntry>& order) override;
+
+	//Blits the framebuffer to the window with GDI on Windows or XPutImage on Linux, does nothing on other platforms
+	void present(GLFWwindow* window) override;
+
+	GLuint createTexture(int width, int height) override;
+	void updateTexture(GLuint texture, int x, int y, int width, int height, const uint32_t* pixels, int stride) override;
+	void destroyTexture(GLuint texture) override;
+
+	//Converts a quad or clear to pixel space and bins it
+	void prepare(const RenderCommand& command);
+
+	//Bins every particle in the command's system on the pool, with a counting sort by tile
+	void prepareParticles(const RenderCommand& command);
+	void rasterizeTile(int tile);
+};
@@ -0,0 +1,82 @@
+#include "StreamBuffer.h"
+#include "GLState.h"
+
+#include <iostream>
+#include <cstring>
+
+void StreamBuffer::init(GLsizeiptr regionSize) {
+	this->regionSize = regionSize;
+
+	//Coherent means we don't have to flush writes ourselves, persistent means it stays mapped while the GPU uses it
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &buffer);
+	glState.bindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferStorage(GL_ARRAY_BUFFER, regionSize * FRAMES, NULL, flags);
+	mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, regionSize * FRAMES, flags);
+	glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!mapped)
+		std::cout << "Error: Failed to map stream buffer" << std::endl;
+}
+
+void StreamBuffer::beginFrame() {
+	used = 0;
+
+	GLsync fence = fences[region];
+	if (!fence)
+		return; //Region has never been used
+
+	//Normally this is already signaled, we only wait if the GPU is more than FRAMES - 1 frames behind
+	while (true) {
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); //1 ms, in nanoseconds
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+			break;
+	}
+
+	glDeleteSync(fence);
+	fences[region] = 0;
+}
+
+void* StreamBuffer::alloc(GLsizeiptr size, GLintptr& offset, GLsizeiptr alignment) {
+	GLsizeiptr start = (used + alignment - 1) / alignment * alignment;
+	if (!mapped || start + size > regionSize) {
+		std::cout << "Error: Stream buffer region full, requested " << size << " bytes" << std::endl;
+		return nullptr;
+	}
+
+	used = start + size;
+	offset = region * regionSize + start;
+	return mapped + offset;
+}
+
+GLintptr StreamBuffer::push(const void* data, GLsizeiptr size, GLsizeiptr alignment) {
+	GLintptr offset;
+	void* dest = alloc(size, offset, alignment);
+	if (!dest)
+		return -1;
+
+	memcpy(dest, data, size);
+	return offset;
+}
+
+void StreamBuffer::endFrame() {
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	region = (region + 1) % FRAMES;
+}
+
+void StreamBuffer::destroy() {
+	for (int i = 0; i < FRAMES; i++) {
+		if (fences[i])
+			glDeleteSync(fences[i]);
+		fences[i] = 0;
+	}
+
+	glState.bindBuffer(GL_ARRAY_BUFFER, buffer);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+	glState.deleteBuffer(buffer);
+
+	buffer = 0;
+	mapped = nullptr;
+}
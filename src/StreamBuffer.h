@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glad/glad.h>
+
+//One big persistently mapped buffer for all per-frame geometry, split into FRAMES regions.
+//Each frame writes into its own region, and a fence makes sure the GPU is done reading a region before we write to it again,
+//so uploads never make the driver stall or copy behind our back.
+struct StreamBuffer {
+	static const int FRAMES = 3; //Triple buffered, the CPU can be up to two frames ahead of the GPU
+
+	GLuint buffer = 0;
+	char* mapped = nullptr; //Start of the whole mapping
+	GLsizeiptr regionSize = 0;
+	int region = 0; //Region the current frame writes to
+	GLsizeiptr used = 0; //Bytes used in the current region
+	GLsync fences[FRAMES] = {};
+
+	void init(GLsizeiptr regionSize);
+
+	//Waits until the GPU is finished with the region we're about to reuse
+	void beginFrame();
+
+	//Reserves size bytes in the current region and returns a pointer to write them to, or nullptr if the region is full.
+	//offset is set to where the data starts in buffer, for glBindVertexBuffer etc.
+	void* alloc(GLsizeiptr size, GLintptr& offset, GLsizeiptr alignment = 16);
+
+	//Same as alloc, but copies data in, returns the offset or -1 if the region is full
+	GLintptr push(const void* data, GLsizeiptr size, GLsizeiptr alignment = 16);
+
+	//Fences everything drawn from the current region and moves on to the next one
+	void endFrame();
+
+	void destroy();
+};
@@ -0,0 +1,74 @@
+#include "TextLayout.h"
+#include "RenderQueue.h"
+
+void TextLayout::init(FontAsset& font, float x, float y, float size, TextAlign align, float r, float g, float b, float a) {
+	this->font = &font;
+	this->x = x;
+	this->y = y;
+	this->size = size;
+	this->align = align;
+	this->r = r;
+	this->g = g;
+	this->b = b;
+	this->a = a;
+	version = UINT32_MAX; //So the first outdated() is true whatever the caller counts from
+	text.clear();
+	dirty = true;
+}
+
+void TextLayout::set(uint32_t version, const std::string& text) {
+	this->version = version;
+	if (text == this->text)
+		return;
+
+	this->text = text;
+	dirty = true;
+}
+
+void TextLayout::draw(TextGroup& group) {
+	if (dirty) {
+		quads.clear();
+		if (!textRenderer.layout(*font, text, x, y, size, align, r, g, b, a, quads))
+			return; //Font's still loading, try again next frame
+
+		layoutVersion++; //The group rebuilds its list the next time it's drawn
+		dirty = false;
+	}
+
+	group.queued.push_back(this);
+}
+
+void TextLayout::destroy() {
+	quads.clear();
+	text.clear();
+	dirty = false;
+}
+
+void TextGroup::draw() {
+	bool changed = queued.size() != built.size();
+	for (size_t i = 0; i < queued.size() && !changed; i++)
+		changed = queued[i] != built[i].first || queued[i]->layoutVersion != built[i].second;
+
+	if (changed) {
+		quads.instances.clear();
+		built.clear();
+		for (TextLayout* layout : queued) {
+			quads.instances.insert(quads.instances.end(), layout->quads.begin(), layout->quads.end());
+			built.push_back(std::make_pair(layout, layout->layoutVersion));
+		}
+		quads.version++; //Uploaded by the GL backend the next time it's drawn
+	}
+
+	if (!quads.instances.empty()) {
+		FontAsset& font = *queued.front()->font;
+		renderQueue.drawQuadList(LAYER_UI, textRenderer.program(font), textRenderer.atlas->textureID, &quads);
+	}
+
+	queued.clear();
+}
+
+void TextGroup::destroy() {
+	quads.destroy();
+	queued.clear();
+	built.clear();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AssetManager.h"
+#include "QuadBatch.h"
+#include "TextRenderer.h"
+
+struct TextGroup;
+
+//A string laid out once and kept as quads, so drawing it again needs no glyph lookups and no layout.
+//Only re-laid out when set() gets different text, or once the font finishes loading.
+//Callers hand set() a version number of whatever the text is made from, and skip building the string at all while
+//outdated() says nothing changed, so a static or rarely changing string costs nothing per frame.
+//Layouts are drawn through a TextGroup, which keeps every string drawn with it in one retained list
+struct TextLayout {
+	FontAsset* font = nullptr;
+	float x = 0, y = 0, size = 0; //Pixels, see TextRenderer
+	TextAlign align = TEXT_LEFT;
+	float r = 1, g = 1, b = 1, a = 1;
+
+	std::string text;
+	uint32_t version = 0; //Caller's, from the last set()
+	bool dirty = false; //Text changed but isn't laid out yet
+
+	std::vector<QuadBatch::Instance> quads;
+	uint32_t layoutVersion = 0; //Bumped every time quads is laid out again
+
+	void init(FontAsset& font, float x, float y, float size, TextAlign align = TEXT_LEFT,
+		float r = 1.0f, float g = 1.0f, float b = 1.0f, float a = 1.0f);
+
+	bool outdated(uint32_t version) const { return version != this->version; }
+
+	//Lays out again on the next draw() if text is different, the same text just takes the new version
+	void set(uint32_t version, const std::string& text);
+
+	//Adds it to group's list for this frame, nothing until the font is ready
+	void draw(TextGroup& group);
+
+	void destroy();
+};
+
+//Every layout drawn with it in a frame, concatenated into one QuadList and recorded as one command on LAYER_UI, so
+//the whole HUD is a single draw. The list is only rebuilt, and uploaded again, when a layout in it was laid out
+//again or the set of layouts drawn changed. Every layout in a group has to use the same font
+struct TextGroup {
+	std::vector<TextLayout*> queued; //This frame's, in draw() order
+	std::vector<std::pair<TextLayout*, uint32_t>> built; //Layouts and their layoutVersion that quads was built from
+	QuadList quads;
+
+	//Records the list with renderQueue, call once a frame after every layout's draw()
+	void draw();
+
+	void destroy();
+};
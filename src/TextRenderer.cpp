@@ -0,0 +1,107 @@
+#include "TextRenderer.h"
+#include "ShaderPermutations.h"
+
+#include <iostream>
+
+TextRenderer textRenderer;
+
+//Next codepoint from UTF-8, malformed bytes come out as themselves
+static uint32_t nextCodepoint(const std::string& text, size_t& i) {
+	unsigned char c = (unsigned char)text[i++];
+	int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+	if (extra == 0 || i + extra > text.size())
+		return c;
+
+	uint32_t codepoint = c & (0x3F >> extra);
+	for (int n = 0; n < extra; n++)
+		codepoint = (codepoint << 6) | ((unsigned char)text[i++] & 0x3F);
+
+	return codepoint;
+}
+
+void TextRenderer::init(TextureAtlas* atlas, int screenWidth, int screenHeight) {
+	this->atlas = atlas;
+	this->screenWidth = screenWidth;
+	this->screenHeight = screenHeight;
+	glyphs.clear();
+}
+
+const CachedGlyph* TextRenderer::glyph(FontAsset& font, uint32_t codepoint) {
+	auto key = std::make_tuple((const FontAsset*)&font, font.pixelSize, codepoint);
+	auto cached = glyphs.find(key);
+	if (cached != glyphs.end())
+		return &cached->second;
+
+	const Glyph* source = font.glyph(codepoint);
+	if (!source)
+		return nullptr;
+
+	CachedGlyph& glyph = glyphs[key];
+	glyph.width = source->width;
+	glyph.height = source->height;
+	glyph.bearingX = source->bearingX;
+	glyph.bearingY = source->bearingY;
+	glyph.advance = source->advance;
+
+	if (source->width > 0 && source->height > 0) {
+		std::string name = (font.sdf ? "sdf:" : "") + font.path + "@" + std::to_string(font.pixelSize) + ":" + std::to_string(codepoint);
+		glyph.inAtlas = atlas->add(name, source->pixels.data(), source->width, source->height, 1, glyph.region);
+		if (!glyph.inAtlas)
+			std::cout << "Error: Glyph atlas is full, can't add " << name << std::endl;
+	}
+
+	return &glyph;
+}
+
+float TextRenderer::measure(FontAsset& font, const std::string& text, float size) {
+	float scale = size / font.pixelSize;
+	float width = 0;
+	for (size_t i = 0; i < text.size();) {
+		const CachedGlyph* cached = glyph(font, nextCodepoint(text, i));
+		if (cached)
+			width += cached->advance * scale;
+	}
+
+	return width;
+}
+
+GLuint TextRenderer::program(const FontAsset& font) {
+	//Glyphs are white with their coverage, or distance with SDF, in alpha
+	return font.sdf ? shaders.get<SHADER_QUAD, SHADER_COLORED | SHADER_TEXTURED | SHADER_SDF>() :
+		shaders.get<SHADER_QUAD, SHADER_COLORED | SHADER_TEXTURED>();
+}
+
+bool TextRenderer::layout(FontAsset& font, const std::string& text, float x, float y, float size, TextAlign align,
+	float r, float g, float b, float a, std::vector<QuadBatch::Instance>& quads) {
+	if (!font.ready())
+		return false;
+
+	if (align == TEXT_CENTER)
+		x -= measure(font, text, size) / 2;
+	else if (align == TEXT_RIGHT)
+		x -= measure(font, text, size);
+
+	float scale = size / font.pixelSize;
+
+	//Pixels to NDC
+	const float sx = 2.0f / screenWidth, sy = 2.0f / screenHeight;
+
+	for (size_t i = 0; i < text.size();) {
+		const CachedGlyph* cached = glyph(font, nextCodepoint(text, i));
+		if (!cached)
+			continue;
+
+		if (cached->inAtlas) {
+			float left = x + cached->bearingX * scale;
+			float bottom = y + (cached->bearingY - cached->height) * scale;
+			const AtlasRegion& region = cached->region;
+
+			quads.push_back({ left * sx - 1.0f, bottom * sy - 1.0f, cached->width * scale * sx, cached->height * scale * sy,
+				r, g, b, a, region.u0, region.v0, region.u1, region.v1 });
+		}
+
+		x += cached->advance * scale;
+	}
+
+	return true;
+}
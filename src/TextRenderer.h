@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "AssetManager.h"
+#include "QuadBatch.h"
+#include "TextureAtlas.h"
+
+enum TextAlign {
+	TEXT_LEFT,
+	TEXT_CENTER,
+	TEXT_RIGHT
+};
+
+//A glyph that's been put in the atlas
+struct CachedGlyph {
+	AtlasRegion region;
+	bool inAtlas = false; //False for blank glyphs like space, or if the atlas was full
+	int width = 0, height = 0, bearingX = 0, bearingY = 0, advance = 0; //Pixels, see Glyph
+};
+
+//Lays strings out as one textured quad per glyph. Every glyph lives in the one atlas and is drawn with the same program,
+//so TextGroup can put all the text in a frame into one list and draw it with a single call.
+//Glyphs are rasterized and packed the first time they're used and cached by (font, pixel size, codepoint).
+//Positions are in pixels from the bottom left of the screen, y is the baseline, and size is the font's pixel size to draw
+//at. Distance field fonts stay sharp at any size, coverage fonts blur when drawn much bigger than they were rasterized.
+struct TextRenderer {
+	TextureAtlas* atlas = nullptr;
+	int screenWidth = 0, screenHeight = 0;
+	std::map<std::tuple<const FontAsset*, int, uint32_t>, CachedGlyph> glyphs;
+
+	void init(TextureAtlas* atlas, int screenWidth, int screenHeight);
+
+	//nullptr if the font isn't loaded yet or doesn't have it
+	const CachedGlyph* glyph(FontAsset& font, uint32_t codepoint);
+
+	//Width of text in pixels at size
+	float measure(FontAsset& font, const std::string& text, float size);
+
+	//Text program for the font's kind of glyphs
+	GLuint program(const FontAsset& font);
+
+	//Appends one quad per visible glyph to quads, in NDC. Returns false and adds nothing if the font isn't ready yet.
+	//text is UTF-8. TextLayout keeps the result between frames and draws it
+	bool layout(FontAsset& font, const std::string& text, float x, float y, float size, TextAlign align,
+		float r, float g, float b, float a, std::vector<QuadBatch::Instance>& quads);
+};
+
+extern TextRenderer textRenderer;
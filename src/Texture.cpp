@@ -0,0 +1,196 @@
+#include "Texture.h"
+#include "GLState.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <GLFW/glfw3.h>
+
+//Whether the driver can sample format, BC7 is core but S3TC is an extension
+static bool formatSupported(uint32_t format) {
+	if (format == GL_COMPRESSED_RGBA_BPTC_UNORM)
+		return true;
+
+	return glfwExtensionSupported("GL_EXT_texture_compression_s3tc") == GLFW_TRUE;
+}
+
+void Texture::load(AssetManager& assets, bool gl) {
+	this->gl = gl;
+	state = TEXTURE_DECODING;
+
+	//Whether the driver can use the cooked file is only known once there's a context, so update() decides.
+	//Until then bet on it, a missing extension just means decoding the original late
+	std::string cookedPath = CookedTexture::cookedPath(file);
+	compressed = false;
+	if (gl && assets.exists(cookedPath))
+		cookedFile = assets.loadFile(cookedPath);
+	else
+		image = assets.loadImage(file);
+}
+
+void Texture::update(AssetManager& assets) {
+	switch (state) {
+	case TEXTURE_DECODING:
+		if (cookedFile) {
+			if (!cookedFile->finished())
+				break;
+
+			if (cookedFile->ready() && cooked.parse(cookedFile->data, cookedFile->size, cookedFile->path) && formatSupported(cooked.format)) {
+				compressed = true;
+				width = cooked.width;
+				height = cooked.height;
+				state = TEXTURE_DECODED;
+				break;
+			}
+
+			cookedFile->release();
+			cookedFile.reset();
+			image = assets.loadImage(file);
+			break;
+		}
+
+		if (!image->finished())
+			break;
+
+		if (image->failed()) {
+			state = TEXTURE_FAILED;
+			break;
+		}
+
+		width = image->width;
+		height = image->height;
+		bytes = image->pixels;
+		state = gl ? TEXTURE_DECODED : TEXTURE_READY;
+		break;
+
+	case TEXTURE_DECODED: {
+		glGenTextures(1, &textureID);
+		glState.bindTexture(0, textureID);
+
+		GLsizeiptr size;
+		if (compressed) {
+			//Mips come from the file, and the whole file goes in the pixel buffer so level offsets can be used as is
+			levels = (int)cooked.levels.size();
+			glTexStorage2D(GL_TEXTURE_2D, levels, cooked.format, width, height);
+			size = (GLsizeiptr)cookedFile->size;
+		}
+		else {
+			//Every mip down to 1x1
+			levels = 1;
+			for (int dim = width > height ? width : height; dim > 1; dim /= 2)
+				levels++;
+
+			glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, width, height);
+			size = (GLsizeiptr)width * height * 4;
+		}
+
+		//Configure the texture
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		//Staging buffer the loader thread can write straight into
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glGenBuffers(1, &pbo);
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, flags);
+		mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		state = TEXTURE_COPYING;
+		assets.pool->run([this, size]() {
+			if (compressed) {
+				memcpy(mapped, cookedFile->data, size);
+				cookedFile->release();
+			}
+			else {
+				memcpy(mapped, bytes, size);
+				freePixels();
+			}
+			state = TEXTURE_COPIED;
+		});
+		break;
+	}
+
+	case TEXTURE_COPIED:
+		glState.bindTexture(0, textureID);
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		//With an unpack buffer bound the last argument is an offset, and the copy happens on the GPU's time
+		if (compressed) {
+			for (int i = 0; i < levels; i++) {
+				const CookedTexture::Level& level = cooked.levels[i];
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, cooked.format, level.size, (void*)(size_t)level.offset);
+			}
+			glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		else {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			//Texture is still bound, so the mips are built for this one
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		state = TEXTURE_UPLOADING;
+		break;
+
+	case TEXTURE_UPLOADING: {
+		//Only poll, the pixel buffer can't go away until the GPU has read it
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+			break;
+
+		glDeleteSync(fence);
+		fence = 0;
+
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glState.deleteBuffer(pbo);
+		pbo = 0;
+		mapped = nullptr;
+
+		state = TEXTURE_READY;
+		break;
+	}
+
+	default:
+		break; //Waiting on the loader thread, or done
+	}
+}
+
+void Texture::freePixels() {
+	if (image)
+		image->freePixels();
+	bytes = nullptr;
+}
+
+void Texture::destroy() {
+	freePixels();
+	image.reset();
+	if (cookedFile) {
+		cookedFile->release();
+		cookedFile.reset();
+	}
+	if (fence) {
+		glDeleteSync(fence);
+		fence = 0;
+	}
+	if (pbo) {
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glState.deleteBuffer(pbo);
+		pbo = 0;
+	}
+	if (textureID && gl)
+		glState.deleteTexture(textureID);
+	textureID = 0;
+	state = TEXTURE_EMPTY;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include <glad/glad.h>
+
+#include "AssetManager.h"
+#include "CookedTexture.h"
+
+enum TextureState {
+	TEXTURE_EMPTY,
+	TEXTURE_DECODING, //Asset manager is reading or decoding the file
+	TEXTURE_DECODED, //Waiting for the render thread to make the texture and pixel buffer
+	TEXTURE_COPYING, //Loader thread is copying pixels into the pixel buffer
+	TEXTURE_COPIED, //Waiting for the render thread to start the upload
+	TEXTURE_UPLOADING, //GPU is copying out of the pixel buffer and building mips
+	TEXTURE_READY,
+	TEXTURE_FAILED
+};
+
+//Texture with immutable storage (glTexStorage2D) that loads in the background.
+//Reading and decoding go through the AssetManager and the copy into a pixel unpack buffer happens on its pool, the render thread only ever issues
+//a few cheap GL calls per step from update(), and the actual upload and mip generation run on the GPU.
+//If tools/TextureCooker made a .ctex next to the file and the driver supports its format, that's uploaded instead,
+//already block compressed and with its mips, so there's no decode or mip generation at all.
+struct Texture {
+	std::string file;
+	int width = 0, height = 0, levels = 1;
+	unsigned char* bytes = nullptr; //image's decoded RGBA, freed once it's in the pixel buffer. Kept in CPU mode
+	bool gl = true; //False when there's no GL context, the texture stops at TEXTURE_READY with bytes kept
+	bool compressed = false; //Loading from the cooked file
+	CookedTexture cooked; //Level table, the data itself stays in cookedFile
+	std::shared_ptr<FileAsset> cookedFile; //Set while the cooked file is the one being tried
+	std::shared_ptr<ImageAsset> image;
+
+	GLuint textureID = 0;
+	GLuint pbo = 0;
+	void* mapped = nullptr; //Persistent write mapping of pbo
+	GLsync fence = 0;
+	std::atomic<int> state{ TEXTURE_EMPTY };
+
+	Texture(std::string file) : file(file) { }
+
+	Texture() { } //Default constructor
+
+	//Starts reading the file, makes no GL calls so it can go before the context exists.
+	//gl = false keeps the pixels on the CPU instead of uploading them
+	void load(AssetManager& assets, bool gl);
+
+	//Call once per frame from the render thread until ready(), never blocks
+	void update(AssetManager& assets);
+
+	bool ready() const { return state == TEXTURE_READY; }
+
+	//Drops the CPU copy kept in CPU mode
+	void freePixels();
+
+	void destroy();
+};
@@ -0,0 +1,80 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+
+void TextureAtlas::init(int width, int height, RenderBackend* backend) {
+	this->width = width;
+	this->height = height;
+	this->backend = backend;
+
+	packer.init(width, height);
+	table = AtlasTable();
+	table.width = width;
+	table.height = height;
+	pixels.assign((size_t)width * height, 0);
+	textureID = backend->createTexture(width, height);
+
+	//4x4 so bilinear filtering at the middle texel only ever sees white
+	unsigned char solid[4 * 4 * 4];
+	std::fill(solid, solid + sizeof(solid), (unsigned char)255);
+	add("__white", solid, 4, 4, 4, white);
+
+	//Sample the middle, not the edges
+	white.u0 = white.u1 = (white.x + 2.0f) / width;
+	white.v0 = white.v1 = (white.y + 2.0f) / height;
+}
+
+bool TextureAtlas::add(const std::string& name, const unsigned char* data, int width, int height, int channels, AtlasRegion& region) {
+	int x, y;
+	if (!packer.pack(width, height, x, y))
+		return false;
+
+	for (int row = 0; row < height; row++) {
+		uint32_t* dest = pixels.data() + (size_t)(y + row) * this->width + x;
+		const unsigned char* src = data + (size_t)row * width * channels;
+
+		for (int i = 0; i < width; i++, src += channels) {
+			if (channels == 1)
+				dest[i] = 0x00FFFFFF | ((uint32_t)src[0] << 24);
+			else
+				dest[i] = src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)(channels == 4 ? src[3] : 255) << 24);
+		}
+	}
+
+	if (dirtyX0 >= dirtyX1) {
+		dirtyX0 = x;
+		dirtyY0 = y;
+		dirtyX1 = x + width;
+		dirtyY1 = y + height;
+	}
+	else {
+		dirtyX0 = std::min(dirtyX0, x);
+		dirtyY0 = std::min(dirtyY0, y);
+		dirtyX1 = std::max(dirtyX1, x + width);
+		dirtyY1 = std::max(dirtyY1, y + height);
+	}
+
+	region = table.add(name, x, y, width, height);
+	return true;
+}
+
+const AtlasRegion* TextureAtlas::find(const std::string& name) const {
+	auto found = table.regions.find(name);
+	return found == table.regions.end() ? nullptr : &found->second;
+}
+
+void TextureAtlas::upload() {
+	if (dirtyX0 >= dirtyX1)
+		return;
+
+	backend->updateTexture(textureID, dirtyX0, dirtyY0, dirtyX1 - dirtyX0, dirtyY1 - dirtyY0,
+		pixels.data() + (size_t)dirtyY0 * width + dirtyX0, width);
+	dirtyX0 = dirtyX1 = 0;
+}
+
+void TextureAtlas::destroy() {
+	if (textureID)
+		backend->destroyTexture(textureID);
+	textureID = 0;
+	pixels.clear();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AtlasPacker.h"
+#include "RenderBackend.h"
+
+//Atlas built at runtime, for things that only exist once we're running, like rasterized glyphs.
+//Images are packed into a CPU copy, and upload() sends the part that changed to the backend's texture once per frame,
+//so everything in it can be drawn with one bound texture.
+struct TextureAtlas {
+	int width = 0, height = 0;
+	AtlasPacker packer;
+	AtlasTable table;
+	std::vector<uint32_t> pixels; //RGBA, row 0 is v = 0
+
+	RenderBackend* backend = nullptr;
+	GLuint textureID = 0;
+
+	//Area changed since the last upload, empty when x0 >= x1
+	int dirtyX0 = 0, dirtyY0 = 0, dirtyX1 = 0, dirtyY1 = 0;
+
+	AtlasRegion white; //Solid white texels, so untextured quads can share the atlas texture
+
+	void init(int width, int height, RenderBackend* backend);
+
+	//Packs an image, channels is 1 (coverage, stored as white with that alpha), 3 or 4. Returns false if it's full
+	bool add(const std::string& name, const unsigned char* data, int width, int height, int channels, AtlasRegion& region);
+
+	//nullptr if name was never added
+	const AtlasRegion* find(const std::string& name) const;
+
+	//Render thread, sends the dirty area to the backend
+	void upload();
+
+	void destroy();
+};
@@ -0,0 +1,115 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <atomic>
+#include <memory>
+
+void ThreadPool::start(int threads) {
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency() - 1;
+	if (threads < 1)
+		threads = 1;
+
+	stopping = false;
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back([this, i]() {
+			PROFILE_THREAD("worker " + std::to_string(i));
+			while (true) {
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+					if (jobs.empty())
+						return; //Stopping and nothing left to do
+
+					job = std::move(jobs.front());
+					jobs.pop_front();
+				}
+
+				PROFILE_SCOPE("job");
+				job();
+			}
+		});
+	}
+}
+
+void ThreadPool::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+	workers.clear();
+}
+
+void ThreadPool::run(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	wake.notify_one();
+}
+
+//Shared between a parallelFor call and its helpers, helpers that start late may outlive the call
+struct ParallelForState {
+	std::atomic<int> next{ 0 };
+	int count = 0;
+	const std::function<void(int)>* fn = nullptr;
+
+	std::mutex mutex;
+	std::condition_variable done;
+	int running = 0; //Helpers currently inside fn
+	bool closed = false; //Set once the caller ran out of work, late helpers see this and leave
+};
+
+static void runParallelFor(ParallelForState& state) {
+	int i;
+	while ((i = state.next.fetch_add(1)) < state.count)
+		(*state.fn)(i);
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn) {
+	if (count <= 0)
+		return;
+
+	std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+	state->count = count;
+	state->fn = &fn;
+
+	int helpers = (int)workers.size();
+	if (helpers > count - 1)
+		helpers = count - 1;
+
+	if (helpers > 0) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (int i = 0; i < helpers; i++) {
+				jobs.push_front([state]() {
+					{
+						std::lock_guard<std::mutex> lock(state->mutex);
+						if (state->closed)
+							return;
+						state->running++;
+					}
+
+					runParallelFor(*state);
+
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->running--;
+					state->done.notify_all();
+				});
+			}
+		}
+		wake.notify_all();
+	}
+
+	runParallelFor(*state);
+
+	//Everything is claimed, wait for helpers still working on their last item
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->closed = true;
+	state->done.wait(lock, [&]() { return state->running == 0; });
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads shared by everything that wants to run work in parallel
+struct ThreadPool {
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+
+	//threads = 0 uses one worker per hardware thread, minus the calling thread
+	void start(int threads = 0);
+
+	//Finishes queued jobs, then joins the workers
+	void stop();
+
+	//Queues a job to run on some worker, doesn't wait for it
+	void run(std::function<void()> job);
+
+	//Calls fn(i) for every i in [0, count) across the workers and the calling thread, returns once all calls are done.
+	//Helpers jump the queue, and any that only get to run after the caller finished everything just do nothing,
+	//so a long job already in the queue can't hold up a frame.
+	void parallelFor(int count, const std::function<void(int)>& fn);
+
+	int threadCount() const { return (int)workers.size() + 1; } //Workers plus the caller
+};
@@ -0,0 +1,35 @@
+#version 430 core
+//One step down the bloom chain, source is twice the size of the target. BRIGHT_PASS is the first step, reading the scene
+//and keeping only what's bright enough to glow
+in vec2 uv;
+out vec4 color;
+
+layout(binding = 0) uniform sampler2D source;
+layout(location = 0) uniform vec2 texelSize; //Of source
+layout(location = 1) uniform vec2 sourceScale; //Part of source that's in use, the scene can be smaller than its texture
+
+const float THRESHOLD = 0.6;
+
+vec3 tap(vec2 at) {
+	//Stay inside the used part, or bilinear taps on the edge would pull in whatever was drawn there at a bigger scale
+	return texture(source, min(at * sourceScale, sourceScale - texelSize * 0.5)).rgb;
+}
+
+void main() {
+	//Dual filter downsample, the middle plus four bilinear taps on the diagonals. Each tap averages four texels,
+	//so this is a smooth 16 texel footprint for 5 fetches, and repeated down the chain it ends up close to a gaussian
+	vec2 offset = texelSize / sourceScale; //One source texel, in uv
+	vec3 sum = tap(uv) * 4.0;
+	sum += tap(uv + vec2(-offset.x, -offset.y));
+	sum += tap(uv + vec2(offset.x, -offset.y));
+	sum += tap(uv + vec2(-offset.x, offset.y));
+	sum += tap(uv + vec2(offset.x, offset.y));
+	sum /= 8.0;
+
+#ifdef BRIGHT_PASS
+	float brightness = max(sum.r, max(sum.g, sum.b));
+	sum *= max(brightness - THRESHOLD, 0.0) / max(brightness, 0.0001);
+#endif
+
+	color = vec4(sum, 1.0);
+}
\ No newline at end of file
@@ -1,6 +1,28 @@
 #version 400
+//Built per variant by ShaderPermutations, COLORED, TEXTURED and SDF are #defined above this when the variant has them
+in vec4 vertColor;
+in vec2 TexCoords;
 out vec4 FragColor; //Output with out
 
+#ifdef TEXTURED
+uniform sampler2D quadTexture; //Unit 0
+#endif
+
 void main() {
-	FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f); //RGBA, this is white
+	vec4 color = vec4(1.0); //Rects default to white
+
+#ifdef COLORED
+	color = vertColor; //RGBA
+#endif
+#if defined(TEXTURED) && defined(SDF)
+	//Alpha is a distance field, 0.5 is the edge. Smoothing over one screen pixel's worth of distance keeps edges sharp
+	//at any scale
+	float distance = texture(quadTexture, TexCoords).a;
+	float smoothing = max(fwidth(distance) * 0.5, 0.0001);
+	color.a *= smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+#elif defined(TEXTURED)
+	color *= texture(quadTexture, TexCoords);
+#endif
+
+	FragColor = color;
 }
\ No newline at end of file
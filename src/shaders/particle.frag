@@ -0,0 +1,10 @@
+#version 430 core
+//Soft round dot, drawn additively so overlapping sparks build up to white
+in vec2 offset;
+in vec4 particleColor;
+out vec4 FragColor;
+
+void main() {
+	float falloff = clamp(1.0 - dot(offset, offset), 0.0, 1.0);
+	FragColor = vec4(particleColor.rgb, particleColor.a * falloff * falloff);
+}
\ No newline at end of file
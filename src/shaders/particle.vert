@@ -0,0 +1,16 @@
+#version 430 core
+//One unit quad per particle, instanced from ParticleSystem's buffer
+layout(location = 0) in vec2 corner; //(0, 0) to (1, 1)
+layout(location = 1) in vec3 particle; //Per instance, center x, y and height in NDC
+layout(location = 2) in vec4 color; //Per instance, alpha already faded by age
+
+layout(location = 0) uniform float aspect; //Screen height / width, keeps particles square
+
+out vec2 offset; //From the center, -1 to 1
+out vec4 particleColor;
+
+void main() {
+	offset = corner * 2.0 - 1.0;
+	particleColor = color;
+	gl_Position = vec4(particle.xy + offset * 0.5 * particle.z * vec2(aspect, 1.0), 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#version 430 core
+//Every post effect in one pass over the target, built per variant with CRT, BLOOM and SCANLINES #defined for the ones
+//that are on. Also stretches the scene up to the target, so dynamic resolution doesn't need its own blit
+in vec2 uv;
+out vec4 color;
+
+const int BLOOM_LEVELS = 4; //PostProcess::BLOOM_LEVELS
+
+layout(binding = 0) uniform sampler2D scene;
+layout(binding = 1) uniform sampler2D bloom[BLOOM_LEVELS]; //Half size, then a quarter and so on, units 1 to 4
+layout(location = 0) uniform vec2 sceneScale; //Part of the scene texture that's in use
+layout(location = 1) uniform vec2 sceneTexel; //Size of a scene texel in uv
+layout(location = 2) uniform vec2 targetSize; //Pixels
+
+const float CURVATURE = 0.08; //Barrel distortion at the corners
+const float VIGNETTE = 0.35;
+const float BLOOM_STRENGTH = 0.8;
+const float SCANLINE_DEPTH = 0.3; //How much darker the gaps between lines are
+const float SCANLINE_PIXELS = 3.0; //Target pixels per line
+
+void main() {
+	vec2 at = uv;
+
+#ifdef CRT
+	//Push the picture out towards the corners like a curved tube, anything pushed off the glass is black
+	vec2 centered = at * 2.0 - 1.0;
+	centered *= 1.0 + CURVATURE * dot(centered, centered);
+	at = centered * 0.5 + 0.5;
+	if (any(lessThan(at, vec2(0.0))) || any(greaterThan(at, vec2(1.0)))) {
+		color = vec4(0.0, 0.0, 0.0, 1.0);
+		return;
+	}
+#endif
+
+	vec3 result = texture(scene, min(at * sceneScale, sceneScale - sceneTexel * 0.5)).rgb;
+
+#ifdef BLOOM
+	//Each level is blurrier than the last, adding them all gives a tight core with a wide falloff
+	vec3 glow = vec3(0.0);
+	for (int i = 0; i < BLOOM_LEVELS; i++)
+		glow += texture(bloom[i], at).rgb;
+	result += glow * (BLOOM_STRENGTH / BLOOM_LEVELS);
+#endif
+
+#ifdef SCANLINES
+	//Follows the distorted coordinates, so the lines bend with the CRT curve
+	float line = 0.5 + 0.5 * cos(at.y * targetSize.y * 6.2831853 / SCANLINE_PIXELS);
+	result *= 1.0 - SCANLINE_DEPTH * line;
+#endif
+
+#ifdef CRT
+	vec2 edge = uv * (1.0 - uv);
+	result *= mix(1.0, pow(edge.x * edge.y * 16.0, 0.25), VIGNETTE);
+#endif
+
+	color = vec4(result, 1.0);
+}
\ No newline at end of file
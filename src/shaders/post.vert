@@ -0,0 +1,9 @@
+#version 430 core
+//One triangle that covers the whole target, no vertex buffer, PostProcess draws 3 vertices with an empty VAO
+out vec2 uv;
+
+void main() {
+	//Vertices at (0, 0), (2, 0) and (0, 2) in UV, the parts outside the screen get clipped
+	uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
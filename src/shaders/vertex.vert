@@ -1,9 +1,17 @@
 //Target OpenGL Version: 4.0.0
 #version 400
 
-//in declare input variables
-in vec3 pos;
+//in declare input variables, locations match QuadBatch
+layout (location = 0) in vec2 corner; //Corner of the unit quad, (0, 0) to (1, 1)
+layout (location = 1) in vec4 rect; //Per instance, x, y, width, height
+layout (location = 2) in vec4 color; //Per instance
+layout (location = 3) in vec4 texRect; //Per instance, texture coords of the bottom left and top right corners
+
+out vec4 vertColor;
+out vec2 TexCoords;
 
 void main() {
-	gl_Position = vec4(pos, 1.0);
+	gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);
+	vertColor = color;
+	TexCoords = mix(texRect.xy, texRect.zw, corner);
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "BCEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <emmintrin.h> //SSE2
+
+//Per channel min and max of a block, endpoints for the channels that go the opposite way to the
+//channel with the biggest range are swapped, so the min-max line runs along the colors instead of across them
+static void findEndpoints(const uint8_t* block, int channels, int* low, int* high) {
+	//Bounding box, 4 pixels at a time
+	__m128i minV = _mm_loadu_si128((const __m128i*)block), maxV = minV;
+	for (int row = 1; row < 4; row++) {
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(block + row * 16));
+		minV = _mm_min_epu8(minV, pixels);
+		maxV = _mm_max_epu8(maxV, pixels);
+	}
+
+	//Fold the 4 pixels in each register into one
+	minV = _mm_min_epu8(minV, _mm_shuffle_epi32(minV, _MM_SHUFFLE(1, 0, 3, 2)));
+	minV = _mm_min_epu8(minV, _mm_shuffle_epi32(minV, _MM_SHUFFLE(2, 3, 0, 1)));
+	maxV = _mm_max_epu8(maxV, _mm_shuffle_epi32(maxV, _MM_SHUFFLE(1, 0, 3, 2)));
+	maxV = _mm_max_epu8(maxV, _mm_shuffle_epi32(maxV, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	uint32_t minPacked = (uint32_t)_mm_cvtsi128_si32(minV), maxPacked = (uint32_t)_mm_cvtsi128_si32(maxV);
+
+	int main = 0;
+	for (int c = 0; c < channels; c++) {
+		low[c] = (minPacked >> (c * 8)) & 0xFF;
+		high[c] = (maxPacked >> (c * 8)) & 0xFF;
+		if (high[c] - low[c] > high[main] - low[main])
+			main = c;
+	}
+
+	//Sign of the covariance with the main channel
+	float mean[4] = {};
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < channels; c++)
+			mean[c] += block[i * 4 + c] / 16.0f;
+	}
+
+	for (int c = 0; c < channels; c++) {
+		if (c == main)
+			continue;
+
+		float covariance = 0;
+		for (int i = 0; i < 16; i++)
+			covariance += (block[i * 4 + c] - mean[c]) * (block[i * 4 + main] - mean[main]);
+
+		if (covariance < 0)
+			std::swap(low[c], high[c]);
+	}
+}
+
+//Projects each pixel onto the line from low to high (both 8 bit per channel, alpha only if useAlpha)
+//and writes where it lands as 0 (low) to steps (high), 4 pixels at a time
+static void projectPixels(const uint8_t* block, const int* low, const int* high, bool useAlpha, int steps, int* out) {
+	int dir[4] = { high[0] - low[0], high[1] - low[1], high[2] - low[2], useAlpha ? high[3] - low[3] : 0 };
+	int lowDot = low[0] * dir[0] + low[1] * dir[1] + low[2] * dir[2] + low[3] * dir[3];
+	int length = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2] + dir[3] * dir[3];
+
+	if (length == 0) {
+		for (int i = 0; i < 16; i++)
+			out[i] = 0;
+		return;
+	}
+
+	__m128i dirV = _mm_setr_epi16((short)dir[0], (short)dir[1], (short)dir[2], (short)dir[3], (short)dir[0], (short)dir[1], (short)dir[2], (short)dir[3]);
+	__m128 scale = _mm_set1_ps((float)steps / length);
+	__m128i lowDotV = _mm_set1_epi32(lowDot);
+	__m128i zero = _mm_setzero_si128();
+	__m128i maxStep = _mm_set1_epi32(steps);
+
+	for (int row = 0; row < 4; row++) {
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(block + row * 16));
+
+		//Two pixels per register as 16 bit, madd gives (r*dr + g*dg, b*db + a*da) for each
+		__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), dirV);
+		__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), dirV);
+
+		//Add the halves together to get one dot product per pixel
+		__m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+		__m128i dot = _mm_sub_epi32(_mm_add_epi32(even, odd), lowDotV);
+
+		//Round to the nearest step and clamp to [0, steps]
+		__m128i t = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(dot), scale));
+		t = _mm_and_si128(t, _mm_cmpgt_epi32(t, zero)); //Negative to 0
+		__m128i over = _mm_cmpgt_epi32(t, maxStep);
+		t = _mm_or_si128(_mm_andnot_si128(over, t), _mm_and_si128(over, maxStep));
+
+		_mm_storeu_si128((__m128i*)(out + row * 4), t);
+	}
+}
+
+static uint16_t to565(const int* color) {
+	return (uint16_t)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+}
+
+static void from565(uint16_t packed, int* color) {
+	int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+	color[3] = 255;
+}
+
+void encodeBC1Block(const uint8_t* block, uint8_t* out) {
+	int low[4], high[4];
+	findEndpoints(block, 3, low, high);
+
+	//Pull the endpoints in a little, the extremes are usually outliers
+	for (int c = 0; c < 3; c++) {
+		int inset = (high[c] - low[c]) / 16;
+		high[c] -= inset;
+		low[c] += inset;
+	}
+
+	uint16_t c0 = to565(high), c1 = to565(low);
+	uint32_t indices = 0;
+
+	if (c0 != c1) {
+		//c0 > c1 picks the 4 color mode
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		//Project against what the decoder will actually see
+		int p0[4], p1[4];
+		from565(c0, p0);
+		from565(c1, p1);
+
+		int t[16];
+		projectPixels(block, p1, p0, false, 3, t);
+
+		//t is 0 at c1 and 3 at c0, BC1 order is c0, c1, 2/3 c0, 1/3 c0
+		const uint32_t order[4] = { 1, 3, 2, 0 };
+		for (int i = 0; i < 16; i++)
+			indices |= order[t[i]] << (i * 2);
+	}
+
+	out[0] = (uint8_t)(c0 & 0xFF);
+	out[1] = (uint8_t)(c0 >> 8);
+	out[2] = (uint8_t)(c1 & 0xFF);
+	out[3] = (uint8_t)(c1 >> 8);
+	memcpy(out + 4, &indices, 4);
+}
+
+//BC3's alpha half, the same layout as BC4
+static void encodeAlphaBlock(const uint8_t* block, uint8_t* out) {
+	int a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; i++) {
+		a0 = std::max(a0, (int)block[i * 4 + 3]);
+		a1 = std::min(a1, (int)block[i * 4 + 3]);
+	}
+
+	uint64_t indices = 0;
+	if (a0 != a1) {
+		//a0 > a1 picks the 8 value mode, index 0 is a0, 1 is a1, 2-7 step from a0 to a1
+		for (int i = 0; i < 16; i++) {
+			int t = ((block[i * 4 + 3] - a1) * 7 + (a0 - a1) / 2) / (a0 - a1);
+			uint64_t index = t == 7 ? 0 : (t == 0 ? 1 : 8 - t);
+			indices |= index << (i * 3);
+		}
+	}
+
+	out[0] = (uint8_t)a0;
+	out[1] = (uint8_t)a1;
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+void encodeBC3Block(const uint8_t* block, uint8_t* out) {
+	encodeAlphaBlock(block, out);
+	encodeBC1Block(block, out + 8);
+}
+
+//Writes bits into a 128 bit block, lowest bit first
+struct BitWriter {
+	uint8_t* out;
+	int position = 0;
+
+	void write(uint32_t value, int bits) {
+		for (int i = 0; i < bits; i++, position++) {
+			if (value & (1u << i))
+				out[position / 8] |= (uint8_t)(1u << (position % 8));
+		}
+	}
+};
+
+//Best 7 bit value plus shared p bit for an 8 bit endpoint, across all 4 channels
+static void quantizeBC7Endpoint(const int* color, int* quantized, int& pBit) {
+	int bestError = -1;
+
+	for (int p = 0; p < 2; p++) {
+		int candidate[4], error = 0;
+		for (int c = 0; c < 4; c++) {
+			candidate[c] = std::min(127, std::max(0, (color[c] - p + 1) >> 1));
+			int expanded = (candidate[c] << 1) | p;
+			error += (expanded - color[c]) * (expanded - color[c]);
+		}
+
+		if (bestError < 0 || error < bestError) {
+			bestError = error;
+			pBit = p;
+			memcpy(quantized, candidate, sizeof(candidate));
+		}
+	}
+}
+
+void encodeBC7Block(const uint8_t* block, uint8_t* out) {
+	int low[4], high[4];
+	findEndpoints(block, 4, low, high);
+
+	int q0[4], q1[4], p0, p1;
+	quantizeBC7Endpoint(low, q0, p0);
+	quantizeBC7Endpoint(high, q1, p1);
+
+	int e0[4], e1[4];
+	for (int c = 0; c < 4; c++) {
+		e0[c] = (q0[c] << 1) | p0;
+		e1[c] = (q1[c] << 1) | p1;
+	}
+
+	//Mode 6 weights are close enough to even that rounding the projection picks the right one
+	int t[16];
+	projectPixels(block, e0, e1, true, 15, t);
+
+	//The first pixel's index is stored with 3 bits, so it has to be < 8, flip the endpoints if it isn't
+	if (t[0] >= 8) {
+		std::swap(q0, q1);
+		std::swap(p0, p1);
+		for (int i = 0; i < 16; i++)
+			t[i] = 15 - t[i];
+	}
+
+	memset(out, 0, 16);
+	BitWriter bits = { out };
+	bits.write(1 << 6, 7); //Mode 6
+	for (int c = 0; c < 4; c++) {
+		bits.write(q0[c], 7);
+		bits.write(q1[c], 7);
+	}
+	bits.write(p0, 1);
+	bits.write(p1, 1);
+
+	bits.write(t[0], 3);
+	for (int i = 1; i < 16; i++)
+		bits.write(t[i], 4);
+}
+
+std::vector<uint8_t> compressImage(BCFormat format, const uint8_t* rgba, int width, int height, ThreadPool* pool) {
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	int blockSize = format == FORMAT_BC1 ? 8 : 16;
+	std::vector<uint8_t> out((size_t)blocksX * blocksY * blockSize);
+
+	auto compressRow = [&](int by) {
+		uint8_t block[64];
+
+		for (int bx = 0; bx < blocksX; bx++) {
+			//Gather the 4x4 block, clamping at the edges
+			for (int y = 0; y < 4; y++) {
+				int sy = std::min(by * 4 + y, height - 1);
+				for (int x = 0; x < 4; x++) {
+					int sx = std::min(bx * 4 + x, width - 1);
+					memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+				}
+			}
+
+			uint8_t* dest = out.data() + ((size_t)by * blocksX + bx) * blockSize;
+			if (format == FORMAT_BC1) encodeBC1Block(block, dest);
+			else if (format == FORMAT_BC3) encodeBC3Block(block, dest);
+			else encodeBC7Block(block, dest);
+		}
+	};
+
+	if (pool)
+		pool->parallelFor(blocksY, compressRow);
+	else {
+		for (int by = 0; by < blocksY; by++)
+			compressRow(by);
+	}
+
+	return out;
+}
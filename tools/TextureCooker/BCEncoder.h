@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../../src/ThreadPool.h"
+
+enum BCFormat {
+	FORMAT_BC1, //RGB, 8 bytes per block, alpha is dropped
+	FORMAT_BC3, //RGBA, BC1 color plus an 8 byte alpha block
+	FORMAT_BC7 //RGBA, 16 bytes per block, mode 6 only
+};
+
+//block is 16 RGBA pixels, row by row. out gets 8 (BC1) or 16 (BC3, BC7) bytes
+void encodeBC1Block(const uint8_t* block, uint8_t* out);
+void encodeBC3Block(const uint8_t* block, uint8_t* out);
+void encodeBC7Block(const uint8_t* block, uint8_t* out);
+
+//Compresses a whole RGBA image, rows of blocks are spread across pool. Edge blocks repeat the last row/column
+std::vector<uint8_t> compressImage(BCFormat format, const uint8_t* rgba, int width, int height, ThreadPool* pool);
@@ -0,0 +1,223 @@
+//Converts PNGs (or anything stb_image reads) into block compressed .ctex files with a full mip chain,
+//see src/CookedTexture.h for the format. Pong loads the .ctex instead of the source image when it finds one.
+//
+//Run it from the repo root. Usage: TextureCooker [--format bc1|bc3|bc7] [path ...]
+//Paths can be files or directories, directories are searched recursively. Defaults to "resources".
+//Without --format, images with any transparency get BC3 and opaque ones get BC1.
+//
+//TextureCooker --pack resources.pak [path ...] doesn't cook anything, it puts every file under the paths into one pack
+//(src/AssetPack.h) that Pong maps at startup. Defaults to "resources" and "src/shaders", cook first so the .ctex files go in too.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stb/stb_image.h>
+
+#include "BCEncoder.h"
+#include "../../src/AssetPack.h"
+#include "../../src/CookedTexture.h"
+#include "../../src/ThreadPool.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+//Half size with a 2x2 box filter, odd edges reuse the last row/column
+static vector<uint8_t> downsample(const vector<uint8_t>& source, int width, int height, int& newWidth, int& newHeight) {
+	newWidth = max(1, width / 2);
+	newHeight = max(1, height / 2);
+	vector<uint8_t> out((size_t)newWidth * newHeight * 4);
+
+	for (int y = 0; y < newHeight; y++) {
+		int y0 = min(y * 2, height - 1), y1 = min(y * 2 + 1, height - 1);
+		for (int x = 0; x < newWidth; x++) {
+			int x0 = min(x * 2, width - 1), x1 = min(x * 2 + 1, width - 1);
+			for (int c = 0; c < 4; c++) {
+				int sum = source[((size_t)y0 * width + x0) * 4 + c] + source[((size_t)y0 * width + x1) * 4 + c] +
+					source[((size_t)y1 * width + x0) * 4 + c] + source[((size_t)y1 * width + x1) * 4 + c];
+				out[((size_t)y * newWidth + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+			}
+		}
+	}
+
+	return out;
+}
+
+//Compresses an RGBA image and its mips into destination
+static bool writeCooked(const string& destination, vector<uint8_t> level, int width, int height, int forcedFormat, ThreadPool& pool) {
+	auto begin = chrono::steady_clock::now();
+
+	BCFormat format;
+	if (forcedFormat >= 0)
+		format = (BCFormat)forcedFormat;
+	else {
+		bool opaque = true;
+		for (size_t i = 3; i < level.size() && opaque; i += 4)
+			opaque = level[i] == 255;
+		format = opaque ? FORMAT_BC1 : FORMAT_BC3;
+	}
+
+	const uint32_t glFormats[] = { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RGBA_BPTC_UNORM };
+	const char* names[] = { "BC1", "BC3", "BC7" };
+
+	vector<vector<uint8_t>> levels;
+	int levelWidth = width, levelHeight = height;
+	while (true) {
+		levels.push_back(compressImage(format, level.data(), levelWidth, levelHeight, &pool));
+		if (levelWidth == 1 && levelHeight == 1)
+			break;
+
+		level = downsample(level, levelWidth, levelHeight, levelWidth, levelHeight);
+	}
+
+	if (!CookedTexture::write(destination, glFormats[format], width, height, levels)) {
+		cout << "Error: Failed to write " << destination << endl;
+		return false;
+	}
+
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+	cout << destination << " (" << names[format] << ", " << width << "x" << height << ", " << levels.size() << " mips, " << ms << " ms)" << endl;
+	return true;
+}
+
+static bool loadImage(const fs::path& source, vector<uint8_t>& pixels, int& width, int& height) {
+	int channels;
+	uint8_t* data = stbi_load(source.string().c_str(), &width, &height, &channels, 4);
+	if (!data) {
+		cout << "Error: Failed to load " << source.string() << ": " << stbi_failure_reason() << endl;
+		return false;
+	}
+
+	pixels.assign(data, data + (size_t)width * height * 4);
+	stbi_image_free(data);
+	return true;
+}
+
+static bool cook(const fs::path& source, int forcedFormat, ThreadPool& pool) {
+	vector<uint8_t> pixels;
+	int width, height;
+	if (!loadImage(source, pixels, width, height))
+		return false;
+
+	cout << source.string() << " -> ";
+	return writeCooked(CookedTexture::cookedPath(source.string()), pixels, width, height, forcedFormat, pool);
+}
+
+//Every file under paths goes in, named by its path from the repo root the way Pong asks for it
+static bool writePack(const string& output, const vector<string>& paths) {
+	auto begin = chrono::steady_clock::now();
+
+	vector<fs::path> files;
+	for (const string& path : paths) {
+		if (fs::is_directory(path)) {
+			for (const fs::directory_entry& entry : fs::recursive_directory_iterator(path))
+				if (entry.is_regular_file())
+					files.push_back(entry.path());
+		}
+		else
+			files.push_back(path);
+	}
+	sort(files.begin(), files.end());
+
+	vector<AssetPack::Entry> entries;
+	size_t total = 0;
+	for (const fs::path& file : files) {
+		ifstream in(file, ios::binary | ios::ate);
+		if (!in) {
+			cout << "Error: Failed to read " << file.generic_string() << endl;
+			return false;
+		}
+
+		AssetPack::Entry entry;
+		entry.name = file.lexically_normal().generic_string();
+		entry.data.resize((size_t)in.tellg());
+		in.seekg(0);
+		in.read((char*)entry.data.data(), entry.data.size());
+		total += entry.data.size();
+		entries.push_back(move(entry));
+	}
+
+	if (!AssetPack::write(output, entries)) {
+		cout << "Error: Failed to write " << output << endl;
+		return false;
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	cout << "Packed " << entries.size() << " files (" << total / 1024 << " KB) into " << output << " in " << seconds << " s" << endl;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	int forcedFormat = -1;
+	string packOutput;
+	vector<string> paths;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "bc1") == 0) forcedFormat = FORMAT_BC1;
+			else if (strcmp(argv[i], "bc3") == 0) forcedFormat = FORMAT_BC3;
+			else if (strcmp(argv[i], "bc7") == 0) forcedFormat = FORMAT_BC7;
+			else {
+				cout << "Unknown format " << argv[i] << ", expected bc1, bc3 or bc7" << endl;
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc)
+			packOutput = argv[++i];
+		else
+			paths.push_back(argv[i]);
+	}
+
+	if (!packOutput.empty()) {
+		if (paths.empty())
+			paths = { "resources", "src/shaders" };
+
+		return writePack(packOutput, paths) ? 0 : 1;
+	}
+
+	if (paths.empty())
+		paths.push_back("resources");
+
+	ThreadPool pool;
+	pool.start();
+
+	auto begin = chrono::steady_clock::now();
+	int cooked = 0, failed = 0;
+
+	for (const string& path : paths) {
+		vector<fs::path> sources;
+		if (fs::is_directory(path)) {
+			for (const fs::directory_entry& entry : fs::recursive_directory_iterator(path)) {
+				string extension = entry.path().extension().string();
+				for (char& c : extension)
+					c = (char)tolower(c);
+
+				if (entry.is_regular_file() && (extension == ".png" || extension == ".jpg" || extension == ".tga" || extension == ".bmp"))
+					sources.push_back(entry.path());
+			}
+		}
+		else
+			sources.push_back(path);
+
+		for (const fs::path& source : sources) {
+			if (cook(source, forcedFormat, pool)) cooked++;
+			else failed++;
+		}
+	}
+
+	pool.stop();
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	cout << "Cooked " << cooked << " textures in " << seconds << " s";
+	if (failed > 0)
+		cout << ", " << failed << " failed";
+	cout << endl;
+
+	return failed > 0 ? 1 : 0;
+}